@@ -1,53 +1,21 @@
-# driver.pro
+# braking_bad.pro
+# Top-level project: the simulation core library, the grid renderer, the game,
+# and the headless runner.
 
-QT       += core gui widgets multimedia
-CONFIG   += c++17
+TEMPLATE = subdirs
 
-TARGET = driver
-TEMPLATE = app
+SUBDIRS += simcore gridrender driver simrun
 
-# List all header files here
-HEADERS += \
-    carBody.h \
-    coin.h \
-    constants.h \
-    flip.h \
-    fuel.h \
-    intro.h \
-    keylog.h \
-    mainwindow.h \
-    media.h \
-    nitro.h \
-    outro.h \
-    pause.h \
-    point.h \
-    prop.h \
-    wheel.h \
-    line.h \
-    scoreboard.h
+simcore.file     = simcore.pro
+simcore.makefile = Makefile.simcore
 
-# List all source files here
-SOURCES += \
-    carBody.cpp \
-    coin.cpp \
-    flip.cpp \
-    fuel.cpp \
-    intro.cpp \
-    keylog.cpp \
-    main.cpp \
-    mainwindow.cpp \
-    media.cpp \
-    nitro.cpp \
-    outro.cpp \
-    pause.cpp \
-    point.cpp \
-    prop.cpp \
-    wheel.cpp \
-    line.cpp \
-    scoreboard.cpp
+gridrender.file     = gridrender.pro
+gridrender.makefile = Makefile.gridrender
 
-FORMS += \
-    mainwindow.ui
+driver.file     = driver.pro
+driver.makefile = Makefile.driver
+driver.depends  = simcore gridrender
 
-RESOURCES += \
-    assets.qrc
+simrun.file     = simrun.pro
+simrun.makefile = Makefile.simrun
+simrun.depends  = simcore gridrender
@@ -7,18 +7,19 @@
 #include <QPoint>
 #include <constants.h>
 
-CarBody::CarBody() : m_cx(0.0), m_cy(0.0), m_angle(0.0), m_vx(0.0), m_vy(0.0), m_isAlive(true) {}
+CarBody::CarBody(VehicleState& state)
+    : m_state(&state), m_particle(state.addParticle(0.0, 0.0, 0.0)), m_isAlive(true) {}
 
 CarBody::~CarBody() {
     m_wheels.clear();
 }
 
 int CarBody::getX() const {
-    return static_cast<int>(std::round(m_cx));
+    return static_cast<int>(std::round(cx()));
 }
 
 int CarBody::getY() const {
-    return static_cast<int>(std::round(m_cy));
+    return static_cast<int>(std::round(cy()));
 }
 
 void CarBody::addPoints(const QVector<QPoint>& points) {
@@ -50,32 +51,37 @@ void CarBody::finish() {
         cymax = std::max(cymax, static_cast<int>(std::round(point.coords[1])));
     }
 
-    m_cx = (cxmin + cxmax) / 2.0;
-    m_cy = (cymin + cymax) / 2.0;
+    cx() = (cxmin + cxmax) / 2.0;
+    cy() = (cymin + cymax) / 2.0;
 
     for (Point& point : m_points) {
-        point.coords[0] -= m_cx;
-        point.coords[1] -= m_cy;
+        point.coords[0] -= cx();
+        point.coords[1] -= cy();
     }
 
     for (auto& entry : m_attachments) {
         for (Point& point : entry.first) {
-            point.coords[0] -= m_cx;
-            point.coords[1] -= m_cy;
+            point.coords[0] -= cx();
+            point.coords[1] -= cy();
         }
     }
 
     for (auto& point : hitbox) {
-        point.coords[0] -= m_cx;
-        point.coords[1] -= m_cy;
+        point.coords[0] -= cx();
+        point.coords[1] -= cy();
     }
 
     for (Point& point : m_killSwitches) {
-        point.coords[0] -= m_cx;
-        point.coords[1] -= m_cy;
+        point.coords[0] -= cx();
+        point.coords[1] -= cy();
     }
 
-    if (m_wheels.isEmpty()) return;
+    if (m_wheels.isEmpty()) {
+        updatePose();
+        updateWorld();
+        storePrevious();
+        return;
+    }
 
     double averagex = 0;
     double averagey = 0;
@@ -99,56 +105,96 @@ void CarBody::finish() {
     for (Wheel* wheel : m_wheels) {
         attach(wheel);
     }
+    updateWorld();
+    storePrevious();
 }
 
-QVector<QPoint> CarBody::get(int dx, int dy) {
-    QVector<QPoint> newPoints;
-    auto newCenter = Point(m_cx, m_cy).get(dx, dy, 0);
-    for(const Point& point : m_points) {
-        newPoints.append(QPoint(point.coords[0] + newCenter[0], point.coords[1] + newCenter[1]));
-    }
-    return newPoints;
+void CarBody::storePrevious() {
+    m_state->prevX[m_particle] = cx();
+    m_state->prevY[m_particle] = cy();
+    m_prevPointsAngle = m_pointsAngle;
 }
 
-void CarBody::move(int dx, int dy, double angle) {
-    m_cx = dx;
-    m_cy = dy;
-    double angleDelta = angle - m_angle;
+void CarBody::renderPose(int dx, int dy, double alpha, double& x, double& y, double& angle) const {
+    const double prevCx = m_state->prevX[m_particle];
+    const double prevCy = m_state->prevY[m_particle];
+    x = prevCx + (cx() - prevCx) * alpha + dx;
+    y = prevCy + (cy() - prevCy) * alpha + dy;
+    angle = m_prevPointsAngle + (m_pointsAngle - m_prevPointsAngle) * alpha;
+}
 
-    for (Point& point : m_points) {
-        point.coords = Point::rotate(point.coords, angleDelta);
-    }
-    for (Point& point : hitbox) {
-        point.coords = Point::rotate(point.coords, angleDelta);
+void CarShape::pose(const QVector<Point>& local, double x, double y, double angle, QVector<QPoint>& out) {
+    const double c = std::cos(angle), s = std::sin(angle);
+    out.resize(local.size());
+    for (int i = 0; i < local.size(); ++i) {
+        const auto& p = local[i].coords;
+        out[i] = QPoint(int(std::lround(x + p[0] * c - p[1] * s)),
+                        int(std::lround(y + p[0] * s + p[1] * c)));
     }
-    for (auto& entry : m_attachments) {
-        for (Point& point : entry.first) {
-            point.coords = Point::rotate(point.coords, angleDelta);
-        }
-    }
-    for (Point& killSwitch : m_killSwitches) {
-        killSwitch.coords = Point::rotate(killSwitch.coords, angleDelta);
-    }
-    m_angle = angle;
+}
+
+void CarBody::transform(const QVector<Point>& local, QVector<QPoint>& out, int dx, int dy, double alpha) const {
+    double x, y, angle;
+    renderPose(dx, dy, alpha, x, y, angle);
+    CarShape::pose(local, x, y, angle, out);
+}
+
+void CarShape::posed(int index, double x, double y, double angle, QVector<QPoint>& out) const {
+    pose(index < 0 ? outline : attachments[index].first, x, y, angle, out);
+}
+
+void CarBody::get(QVector<QPoint>& out, int dx, int dy, double alpha) const {
+    transform(m_points, out, dx, dy, alpha);
+}
+
+void CarBody::move(int dx, int dy, double angle) {
+    cx() = dx;
+    cy() = dy;
+    m_pointsAngle += angle - bodyAngle();
+    bodyAngle() = angle;
+    updatePose();
 }
 
 void CarBody::rotate(double angle) {
-    double angleDelta = angle - m_angle;
-    for (Point& point : m_points) {
-        point.coords = Point::rotate(point.coords, angleDelta);
-    }
-    for (Point& point : hitbox) {
-        point.coords = Point::rotate(point.coords, angleDelta);
-    }
-    for (auto& entry : m_attachments) {
-        for (Point& point : entry.first) {
-            point.coords = Point::rotate(point.coords, angleDelta);
+    m_pointsAngle += angle - bodyAngle();
+    bodyAngle() = angle;
+    updatePose();
+}
+
+void CarBody::updatePose() {
+    m_poseCos = std::cos(m_pointsAngle);
+    m_poseSin = std::sin(m_pointsAngle);
+    auto rotateAll = [this](const QVector<Point>& local, QVector<Point>& out) {
+        out.resize(local.size());
+        for (int i = 0; i < local.size(); ++i) {
+            const auto& p = local[i].coords;
+            out[i].coords = {p[0] * m_poseCos - p[1] * m_poseSin, p[0] * m_poseSin + p[1] * m_poseCos};
         }
+    };
+    rotateAll(hitbox, m_hitboxPose);
+    rotateAll(m_killSwitches, m_killSwitchPose);
+}
+
+void CarBody::updateWorld() {
+    const double ox = cx(), oy = cy();
+    auto place = [&](const Point& p) {
+        return QPoint(int(std::lround(ox + p.coords[0] * m_poseCos - p.coords[1] * m_poseSin)),
+                      int(std::lround(oy + p.coords[0] * m_poseSin + p.coords[1] * m_poseCos)));
+    };
+
+    const int n = m_points.size();
+    m_worldOutline.resize(n);
+    for (int i = 0; i < n; ++i) m_worldOutline[i] = place(m_points[i]);
+
+    m_worldEdges.resize(n);
+    for (int i = 0; i < n; ++i) {
+        const QPoint& a = m_worldOutline[i];
+        const QPoint& b = m_worldOutline[(i + 1) % n];
+        m_worldEdges[i] = Line(b.x(), b.y(), a.x(), a.y());
     }
-    for (Point& killSwitch : m_killSwitches) {
-        killSwitch.coords = Point::rotate(killSwitch.coords, angleDelta);
-    }
-    m_angle = angle;
+
+    m_worldKillSwitches.resize(m_killSwitches.size());
+    for (int i = 0; i < m_killSwitches.size(); ++i) m_worldKillSwitches[i] = place(m_killSwitches[i]);
 }
 
 void CarBody::addWheel(Wheel* wheel) {
@@ -164,7 +210,6 @@ void CarBody::kill() {
         wheel->updateV(rand_vx, rand_vy);
     }
     m_wheels.clear();
-    m_attachDistances.clear();
 }
 
 bool CarBody::isAlive() const {
@@ -172,159 +217,87 @@ bool CarBody::isAlive() const {
 }
 
 void CarBody::attach(Wheel* wheel) {
-    double dist = std::sqrt(std::pow(wheel->getX() - m_cx, 2) + std::pow(wheel->getY() - m_cy, 2));
-    m_attachDistances.append(dist);
+    m_state->addLink(m_particle, wheel->particle(), Constants::SUSPENSION_COMPLIANCE);
 }
 
-QVector<Line> CarBody::getLines() {
-    QVector<Line> lines;
-    if (m_points.isEmpty()) return lines;
-
-    lines.reserve(m_points.size());
-    for (int i = 0; i < m_points.size(); i++) {
-        std::array<int, 2> p1 = m_points.at((i + 1) % m_points.size()).get(static_cast<int>(std::round(m_cx)), static_cast<int>(std::round(m_cy)), m_angle);
-        std::array<int, 2> p2 = m_points.at(i).get(static_cast<int>(std::round(m_cx)), static_cast<int>(std::round(m_cy)), m_angle);
-        lines.append(Line(p1[0], p1[1], p2[0], p2[1]));
-    }
-    return lines;
-}
+void CarBody::simulate(const BiomeParams& biome, const StepFactors& factors, const TerrainStore& terrain, bool accelerating, bool braking, double stepScale) {
+    const double h = stepScale;
 
-void CarBody::simulate(int level_index, const QVector<Line>& terrain, bool accelerating, bool braking) {
     if (m_isAlive && m_wheels.size() >= 2) {
         double theta = std::atan2(m_wheels[1]->getY() - m_wheels[0]->getY(), m_wheels[1]->getX() - m_wheels[0]->getX());
         rotate(theta);
     }
 
-    m_cx += m_vx;
-    m_cy -= m_vy;
-
-    m_vy -= Constants::GRAVITY[level_index];
-
-    m_vx *= 1 - Constants::AIR_RESISTANCE[level_index];
-    m_vy *= 1 - Constants::AIR_RESISTANCE[level_index];
-
     if(accelerating && braking){
-        m_vy -= Constants::GRAVITY[level_index] * 0.5;
+        vy() -= biome.gravity * 0.5 * h;
     }
 
-    for (const Line& line : terrain) {
-        double m = line.getSlope();
-        double b = line.getIntercept();
+    const double friction = factors.friction;
 
-        for (const Point& point : hitbox) {
-            int x = static_cast<int>(std::round(m_cx + point.coords[0]));
-            int y = static_cast<int>(std::round(m_cy + point.coords[1]));
+    // a contact is taken within 4px of a line, plus the 1px end tolerance below
+    const double clearance = 4.0;
+    const double reach = clearance + 1.0;
 
-            double dist = std::abs(m * x - y + b) / std::sqrt(m * m + 1);
-            double intersectionx = (m * (y - b) + x) / (m * m + 1);
+    // Resolves one body point against the terrain: lift it straight out to the
+    // clearance distance along the segment normal, then reflect velocity in the
+    // segment frame. Kill switches also kill the car and kick the angle.
+    auto resolvePoint = [&](const Point& point, bool killSwitch) {
+        const auto [firstLine, lastLine] = terrain.range(cx() + point.coords[0] - reach, cx() + point.coords[0] + reach);
+        for (int li = firstLine; li < lastLine; ++li) {
+            const Line& line = terrain.segment(li);
+            const double tx = line.tangentX(), ty = line.tangentY();
+            const double nx = line.normalX(),  ny = line.normalY();
 
-            if (dist <= 4 && intersectionx >= line.getX1() - 1 && intersectionx <= line.getX2() + 1) {
-                double intersectiony = m * intersectionx + b;
-                double theta = -std::atan(m);
+            const double rx = cx() + point.coords[0] - line.getX1();
+            const double ry = cy() + point.coords[1] - line.getY1();
+            const double along  = rx * tx + ry * ty;
+            const double height = rx * nx + ry * ny;
 
-                while (dist < 4) {
-                    m_cy -= std::cos(theta);
-                    m_cx -= std::sin(theta);
-                    int cur_x = static_cast<int>(std::round(m_cx + point.coords[0]));
-                    int cur_y = static_cast<int>(std::round(m_cy + point.coords[1]));
-                    dist = std::abs(m * cur_x - cur_y + b) / std::sqrt(m * m + 1);
-                }
+            if (std::abs(height) > clearance || along < -1.0 || along > line.length() + 1.0) continue;
 
-                double vAlongLine = m_vx * std::cos(theta) + m_vy * std::sin(theta);
-                double vNormalToLine = m_vy * std::cos(theta) - m_vx * std::sin(theta);
+            if (killSwitch && m_isAlive) kill();
 
-                vNormalToLine = vNormalToLine * Constants::RESTITUTION[level_index] / (1 + std::exp(-vNormalToLine));
-                vAlongLine *= 1 - Constants::FRICTION[level_index];
+            // foot of the perpendicular, before the push
+            const double footX = line.getX1() + along * tx;
+            const double footY = line.getY1() + along * ty;
 
-                m_vx = vAlongLine * std::cos(theta) - vNormalToLine * std::sin(theta);
-                m_vy = vAlongLine * std::sin(theta) + vNormalToLine * std::cos(theta);
+            if (std::abs(height) < clearance) {
+                const double lift = clearance - height;
+                cx() += lift * nx;
+                cy() += lift * ny;
             }
-        }
 
-        for (const Point& point : m_killSwitches) {
-            int x = static_cast<int>(std::round(m_cx + point.coords[0]));
-            int y = static_cast<int>(std::round(m_cy + point.coords[1]));
+            // velocity is y-up, so its screen-space vector is (vx, -vy)
+            double vAlongLine    = vx() * tx - vy() * ty;
+            double vNormalToLine = vx() * nx - vy() * ny;
 
-            double dist = std::abs(m * x - y + b) / std::sqrt(m * m + 1);
-            double intersectionx = (m * (y - b) + x) / (m * m + 1);
+            vNormalToLine = vNormalToLine * biome.restitution / (1 + std::exp(-vNormalToLine));
+            vAlongLine *= friction;
 
-            if (dist <= 4 && intersectionx >= line.getX1() - 1 && intersectionx <= line.getX2() + 1) {
+            vx() =   vAlongLine * tx + vNormalToLine * nx;
+            vy() = -(vAlongLine * ty + vNormalToLine * ny);
 
-                if (m_isAlive) kill();
-
-                double intersectiony = m * intersectionx + b;
-                double theta = -std::atan(m);
-
-                while (dist < 4) {
-                    m_cy -= std::cos(theta);
-                    m_cx -= std::sin(theta);
-                    int cur_x = static_cast<int>(std::round(m_cx + point.coords[0]));
-                    int cur_y = static_cast<int>(std::round(m_cy + point.coords[1]));
-                    dist = std::abs(m * cur_x - cur_y + b) / std::sqrt(m * m + 1);
-                }
-
-                double vAlongLine = m_vx * std::cos(theta) + m_vy * std::sin(theta);
-                double vNormalToLine = m_vy * std::cos(theta) - m_vx * std::sin(theta);
-
-                vNormalToLine = vNormalToLine * Constants::RESTITUTION[level_index] / (1 + std::exp(-vNormalToLine));
-                vAlongLine *= 1 - Constants::FRICTION[level_index];
-
-                m_vx = vAlongLine * std::cos(theta) - vNormalToLine * std::sin(theta);
-                m_vy = vAlongLine * std::sin(theta) + vNormalToLine * std::cos(theta);
-
-                double torque = 0.01 * ((intersectionx - m_cx) * std::sin(theta) - (intersectiony - m_cy) * std::cos(theta));
-                m_angle += 100 * torque;
+            if (killSwitch) {
+                double torque = 0.01 * (-(footX - cx()) * ty - (footY - cy()) * tx);
+                bodyAngle() += 100 * torque;
             }
         }
-    }
+    };
 
-    for (int i = 0; m_isAlive && i < m_wheels.size(); i++) {
-        Wheel* wheel = m_wheels.at(i);
-        double desiredDistance = m_attachDistances.at(i);
-
-        double deltaX = wheel->getX() - m_cx;
-        double deltaY = wheel->getY() - m_cy;
-        double actualDistance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
-
-        if (actualDistance == 0) continue;
-
-        double displacement = actualDistance - desiredDistance;
-        double springForceMagnitude = displacement * Constants::SPRING_CONSTANT;
-
-        double unitX = -deltaX / actualDistance;
-        double unitY =  deltaY / actualDistance;
-
-        double forceX = unitX * springForceMagnitude;
-        double forceY = unitY * springForceMagnitude;
-
-        // 2. Calculate relative velocity
-        double relativeVx = wheel->getVx() - m_vx;
-        double relativeVy = wheel->getVy() - m_vy;
-
-        // 3. Project relative velocity onto the spring axis (Dot Product)
-        // This isolates the component of velocity that is stretching/compressing the spring
-        double velocityAlongSpring = relativeVx * unitX + relativeVy * unitY;
-
-        // 4. Calculate damping force components based ONLY on that projection
-        double dampingForceX = velocityAlongSpring * unitX * Constants::DAMPING;
-        double dampingForceY = velocityAlongSpring * unitY * Constants::DAMPING;
-
-        m_vx -= (forceX - dampingForceX);
-        m_vy -= (forceY - dampingForceY);
-        wheel->updateV(forceX - dampingForceX, forceY - dampingForceY);
-    }
+    for (const Point& point : m_hitboxPose) resolvePoint(point, false);
+    for (const Point& point : m_killSwitchPose) resolvePoint(point, true);
 
     if (!m_isAlive) {
         double pushUp = 0.0;
-        for (const Point& p : hitbox) {
-            int px = int(std::lround(m_cx + p.coords[0]));
-            int py = int(std::lround(m_cy + p.coords[1]));
-            for (const Line& line : terrain) {
+        for (const Point& p : m_hitboxPose) {
+            int px = int(std::lround(cx() + p.coords[0]));
+            int py = int(std::lround(cy() + p.coords[1]));
+            const auto [firstLine, lastLine] = terrain.range(px, px);
+            for (int li = firstLine; li < lastLine; ++li) {
+                const Line& line = terrain.segment(li);
                 int x1 = line.getX1(), x2 = line.getX2();
                 if (!((x1 <= px && px <= x2) || (x2 <= px && px <= x1))) continue;
-                double m = line.getSlope();
-                double b = line.getIntercept();
-                double gy = m * px + b;
+                double gy = line.yAt(px);
                 double clear = 4.0;
                 double need = py - (gy - clear);
                 if (need > pushUp) pushUp = need;
@@ -332,7 +305,7 @@ void CarBody::simulate(int level_index, const QVector<Line>& terrain, bool accel
             }
         }
         if (pushUp > 0.0)
-            m_cy -= pushUp;
+            cy() -= pushUp;
     }
 }
 
@@ -343,27 +316,14 @@ void CarBody::addAttachment(const QVector<QPoint>& points, const QColor& color)
     m_attachments.append(qMakePair(pts, color));
 }
 
-QVector<QPair<QVector<QPoint>, QColor>> CarBody::getAttachments(int dx, int dy) {
-    QVector<QPair<QVector<QPoint>, QColor>> out;
-    out.reserve(m_attachments.size());
-    auto newCenter = Point(m_cx, m_cy).get(dx, dy, 0);
-    for (const auto& entry : m_attachments) {
-        QVector<QPoint> poly;
-        poly.reserve(entry.first.size());
-        for (const Point& pt : entry.first) {
-            poly.append(QPoint(pt.coords[0] + newCenter[0], pt.coords[1] + newCenter[1]));
-        }
-        out.append(qMakePair(poly, entry.second));
-    }
-    return out;
+int CarBody::attachmentCount() const {
+    return m_attachments.size();
 }
 
-QVector<QPoint> CarBody::getKillSwitches(int dx, int dy) const {
-    QVector<QPoint> out;
-    out.reserve(m_killSwitches.size());
-    auto c = Point(m_cx, m_cy).get(dx, dy, 0);
-    for (const Point& p : m_killSwitches) {
-        out.append(QPoint(p.coords[0] + c[0], p.coords[1] + c[1]));
-    }
-    return out;
+QColor CarBody::attachmentColor(int index) const {
+    return m_attachments[index].second;
+}
+
+void CarBody::getAttachment(int index, QVector<QPoint>& out, int dx, int dy, double alpha) const {
+    transform(m_attachments[index].first, out, dx, dy, alpha);
 }
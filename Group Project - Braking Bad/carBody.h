@@ -10,10 +10,29 @@
 #include "point.h"
 #include "wheel.h"
 #include "line.h"
+#include "terrainstore.h"
+#include "vehiclestate.h"
+
+// A car body's shapes in body space, centred on the body. They are fixed
+// once CarBody::finish() has run, so a render snapshot takes its own copy
+// per round and draws from that rather than from the live body.
+struct CarShape {
+    QVector<Point> outline;
+    QVector<QPair<QVector<Point>, QColor>> attachments;
+    QVector<Point> killSwitches;
+
+    int attachmentCount() const { return attachments.size(); }
+    QColor attachmentColor(int index) const { return attachments[index].second; }
+    // the outline (index -1) or an attachment, centred on (x, y) at the given angle
+    void posed(int index, double x, double y, double angle, QVector<QPoint>& out) const;
+    // local turned by angle and moved to (x, y), rounded to whole pixels
+    static void pose(const QVector<Point>& local, double x, double y, double angle, QVector<QPoint>& out);
+};
 
 class CarBody {
 public:
-    CarBody();
+    // the body centre is a particle of state, linked to its wheels by suspension links
+    explicit CarBody(VehicleState& state);
     virtual ~CarBody();
 
     int getX() const;
@@ -28,9 +47,18 @@ public:
     void finish();
 
     void addAttachment(const QVector<QPoint>& points, const QColor& color);
-    QVector<QPair<QVector<QPoint>, QColor>> getAttachments(int dx, int dy);
-
-    QVector<QPoint> get(int dx, int dy);
+    int attachmentCount() const;
+    QColor attachmentColor(int index) const;
+
+    // Render outlines written into out, which is resized in place so a
+    // caller-held buffer is reused from frame to frame.
+    // alpha blends from the previous step's pose (0) to the current one (1)
+    void get(QVector<QPoint>& out, int dx, int dy, double alpha = 1.0) const;
+    void getAttachment(int index, QVector<QPoint>& out, int dx, int dy, double alpha = 1.0) const;
+    // centre and orientation get() draws at, for the same offsets and alpha
+    void renderPose(int dx, int dy, double alpha, double& x, double& y, double& angle) const;
+    // the body-space outline, attachments and kill switches, as implicitly shared copies
+    CarShape shape() const { return {m_points, m_attachments, m_killSwitches}; }
 
     void move(int dx, int dy, double angle);
     void rotate(double angle);
@@ -40,33 +68,63 @@ public:
     void kill();
     bool isAlive() const;
 
-    QVector<Line> getLines();
+    // World-space outline, its edges and the kill switches for the current
+    // step, refreshed by updateWorld()
+    const QVector<QPoint>& getOutline() const { return m_worldOutline; }
+    const QVector<Line>& getLines() const { return m_worldEdges; }
+    const QVector<QPoint>& getKillSwitches() const { return m_worldKillSwitches; }
+    void updateWorld();
 
-    void simulate(int, const QVector<Line>& terrain, bool accelerating, bool braking);
+    // orientation and terrain contacts; free flight and the wheel links are
+    // integrated by VehicleState
+    // stepScale is the step length in reference ticks (1.0 at PHYSICS_REFERENCE_HZ)
+    // factors is StepFactors::of(biome, stepScale)
+    void simulate(const BiomeParams& biome, const StepFactors& factors, const TerrainStore& terrain, bool accelerating, bool braking, double stepScale = 1.0);
 
-    QVector<QPoint> getKillSwitches(int dx, int dy) const;
+    // remember the current pose as the start of the next step, for render interpolation
+    void storePrevious();
 
 private:
     void attach(Wheel* wheel);
+    // re-derives the contact offsets from the local shapes at m_pointsAngle
+    void updatePose();
+    void transform(const QVector<Point>& local, QVector<QPoint>& out, int dx, int dy, double alpha) const;
 
+    // shapes in body space, centred on the body and never rotated in place
     QVector<Point> m_points;
-
     QVector<Point> hitbox;
+    QVector<QPair<QVector<Point>, QColor>> m_attachments;
+    QVector<Point> m_killSwitches;
+
+    // hitbox and kill switches rotated to m_pointsAngle, for terrain contacts
+    QVector<Point> m_hitboxPose;
+    QVector<Point> m_killSwitchPose;
+    double m_poseCos = 1.0;
+    double m_poseSin = 0.0;
 
-    double m_cx = 0.0;
-    double m_cy = 0.0;
-    double m_angle = 0.0;
-    double m_vx = 0.0;
-    double m_vy = 0.0;
+    QVector<QPoint> m_worldOutline;
+    QVector<Line>   m_worldEdges;
+    QVector<QPoint> m_worldKillSwitches;
+
+    double& cx() { return m_state->x[m_particle]; }
+    double& cy() { return m_state->y[m_particle]; }
+    double& vx() { return m_state->vx[m_particle]; }
+    double& vy() { return m_state->vy[m_particle]; }
+    double cx() const { return m_state->x[m_particle]; }
+    double cy() const { return m_state->y[m_particle]; }
+    double& bodyAngle() { return m_state->angle[m_particle]; }
+
+    VehicleState* m_state;
+    int m_particle;
+
+    // orientation the shapes are drawn and collided at; bodyAngle() can drift from it on kill-switch torque
+    double m_pointsAngle = 0.0;
+    double m_prevPointsAngle = 0.0;
 
     QVector<Wheel*> m_wheels;
-    QVector<double> m_attachDistances;
 
     double wheel_average_desired_distance;
 
-    QVector<QPair<QVector<Point>, QColor>> m_attachments;
-
-    QVector<Point> m_killSwitches;
     bool m_isAlive = true;
 };
 
@@ -6,18 +6,37 @@
 #include <QPoint>
 #include <QHash>
 #include <array>
+#include <cmath>
+
+// Per-level physics. One row per stage, in level_index order.
+struct BiomeParams {
+    double gravity;
+    double airResistance;
+    double restitution;
+    double friction;
+    double traction;
+};
 
 struct Constants {
 
     static constexpr int PIXEL_SIZE = 6;
+    // the world is simulated and drawn at this many cells whatever the window
+    // size, then scaled to fit; 320 x 180 is 1080p at PIXEL_SIZE 6
+    static constexpr int LOGICAL_W_CELLS = 320;
+    static constexpr int LOGICAL_H_CELLS = 180;
+    static constexpr int LOGICAL_CELLS_MIN = 64;
+    static constexpr int LOGICAL_CELLS_MAX = 1024;
     static constexpr int SHADING_BLOCK = 3;
 
     // LEVEL MECHANICS
-    inline static QVector<double> GRAVITY           = {0.08, 0.08, 0.08, 0.04, 0.06, 0.08};
-    inline static QVector<double> AIR_RESISTANCE    = {0.0005, 0.0003, 0.0007, 0.00001, 0.00005, 0.0007};
-    inline static QVector<double> RESTITUTION       = {0.8, 0.5, 0.8, 0.7, 0.07, 0.5};
-    inline static QVector<double> FRICTION          = {0.003, 0.03, 0.0001, 0.001, 0.03, 0.03};
-    inline static QVector<double> TRACTION          = {1, 1.25, 0.5, 0.5, 0.75, 1.5};
+    //                                                    gravity  air      restitution  friction  traction
+    static constexpr std::array<BiomeParams, 6> BIOMES = {{{0.08,    0.0005,  0.8,         0.003,    1   },
+                                                          {0.08,    0.0003,  0.5,         0.03,     1.25},
+                                                          {0.08,    0.0007,  0.8,         0.0001,   0.5 },
+                                                          {0.04,    0.00001, 0.7,         0.001,    0.5 },
+                                                          {0.06,    0.00005, 0.07,        0.03,     0.75},
+                                                          {0.08,    0.0007,  0.5,         0.03,     1.5 }}};
+    static constexpr int BIOME_COUNT = int(BIOMES.size());
     inline static QVector<double> CLOUD_PROBABILITY = {0.5, 0.1, 0.7, 0, 0.05, 0};
     inline static QVector<double> STAR_PROBABILITY = {0, 0, 0, 0.7, 0, 0.7};
     inline static QVector<QColor> SKY_COLOR = {QColor(150,210,255), QColor(255,220,200), QColor(210,210,255), QColor(0,0,0), QColor(200, 150, 150), QColor(30, 30, 40)};
@@ -35,13 +54,27 @@ struct Constants {
     static constexpr double MAX_VELOCITY    = 30.0;
     static constexpr double ACCELERATION    = 0.8;
     static constexpr double DECELERATION    = 0.8;
-    static constexpr double SPRING_CONSTANT = 0.6;
-    static constexpr double DAMPING         = 0.06;
+    // suspension links are solved as XPBD constraints; compliance is inverse
+    // stiffness in reference ticks squared (0 = rigid)
+    static constexpr double AXLE_COMPLIANCE       = 1.0 / 0.6;
+    static constexpr double SUSPENSION_COMPLIANCE = 1.0 / 0.6;
+    static constexpr double LINK_DAMPING          = 0.06;
     static constexpr double ANGULAR_ACCELERATION = 0.0010;
     static constexpr double ANGULAR_DECELERATION = 0.0010;
     static constexpr double ANGULAR_DAMPING      = 0.05;
     static constexpr double MAX_ANGULAR_VELOCITY = 0.04;
 
+    // SIMULATION
+    // the per-tick car constants above were tuned against a 100 Hz tick
+    static constexpr int PHYSICS_REFERENCE_HZ = 100;
+    static constexpr int PHYSICS_HZ           = 120;
+    static constexpr int PHYSICS_HZ_MIN       = 30;
+    static constexpr int PHYSICS_HZ_MAX       = 480;
+    static constexpr int MAX_STEPS_PER_FRAME  = 8;
+    static constexpr int PHYSICS_SUBSTEPS     = 1;
+    static constexpr int PHYSICS_SUBSTEPS_MAX = 16;
+    static constexpr int FRAME_INTERVAL_MS    = 10;
+
     // CAR
     static constexpr QColor CAR_COLOR = QColor(200, 50, 50);
     static constexpr QColor WHEEL_COLOR_OUTER = QColor(40, 50, 60);
@@ -259,4 +292,17 @@ inline const QHash<QChar, std::array<uint8_t,7>> font_map = {
     {'>',{0x10,0x18,0x1C,0x1E,0x1C,0x18,0x10}}
 };
 
+// A stage's per-tick factors raised to one step length of h ticks. h and the
+// stage are fixed for a whole step, so these are worked out once per step
+// rather than on every simulate call.
+struct StepFactors {
+    double friction;         // (1 - friction)^h, tangential speed kept per ground contact
+    double spinBleed;        // 0.9^h, pair spin kept per wheel contact
+    double angularDamping;   // (1 - ANGULAR_DAMPING)^h, pair spin kept while coasting
+
+    static StepFactors of(const BiomeParams& biome, double h) {
+        return {std::pow(1 - biome.friction, h), std::pow(0.9, h), std::pow(1 - Constants::ANGULAR_DAMPING, h)};
+    }
+};
+
 #endif
@@ -0,0 +1,49 @@
+# driver.pro
+
+QT       += core gui widgets multimedia
+CONFIG   += c++17
+
+TARGET = driver
+TEMPLATE = app
+OBJECTS_DIR = .obj/driver
+
+# physics, terrain and pickups come from the simcore library (simcore.pro),
+# the grid canvas and terrain shading from gridrender (gridrender.pro)
+include(simcore.pri)
+include(gridrender.pri)
+
+# List all header files here
+HEADERS += \
+    constants.h \
+    intro.h \
+    itemrenderer.h \
+    keylog.h \
+    mainwindow.h \
+    media.h \
+    outro.h \
+    pause.h \
+    prop.h \
+    scoreboard.h \
+    terraintiles.h \
+    workerthread.h
+
+# List all source files here
+SOURCES += \
+    intro.cpp \
+    itemrenderer.cpp \
+    keylog.cpp \
+    main.cpp \
+    mainwindow.cpp \
+    media.cpp \
+    outro.cpp \
+    pause.cpp \
+    prop.cpp \
+    scoreboard.cpp \
+    terraintiles.cpp \
+    workerthread.cpp
+
+FORMS += \
+    mainwindow.ui
+
+RESOURCES += \
+    assets.qrc
@@ -1,8 +1,6 @@
 // flip.h
 #pragma once
-#include <QPainter>
-#include <QList>
-#include <QString>
+#include <array>
 #include <functional>
 #include "constants.h"
 
@@ -13,33 +11,38 @@ public:
         m_lastAng = 0.0;
         m_accum = 0.0;
         m_cw = m_ccw = 0;
-        m_popups.clear();
+        m_popupCount = 0;
     }
 
     void update(double angleRad, double carX, double carY, double nowSec, const std::function<void(int)>& onAward);
-    void drawHUD(QPainter& p, int levelIndex) const;
-    void drawWorldPopups(QPainter& p, int cameraX, int cameraY, int level_index) const;
 
     int total() const { return m_cw + m_ccw; }
     int cw()    const { return m_cw; }
     int ccw()   const { return m_ccw; }
 
-private:
-    static constexpr double TWO_PI = 6.283185307179586;
-    static constexpr int    COINS_PER_FLIP     = 50;
-    static constexpr double POPUP_LIFETIME     = 1.5; // seconds
-    static constexpr int    POPUP_OFFSET_CELLS = 10;
-
+    // a "Flip!" shown over the car at world pixel (wx, wy) until the given time
     struct Popup {
         int wx, wy;
         double until;
     };
+    // at most MAX_POPUPS, oldest first; a flip past that retires the oldest early
+    static constexpr int MAX_POPUPS = 8;
+    int popupCount() const { return m_popupCount; }
+    const Popup& popup(int i) const { return m_popups[i]; }
 
-    static void drawPixelWordFlip(QPainter& p, int gx, int gy, int cell, const QColor& c);
+private:
+    static constexpr double TWO_PI = 6.283185307179586;
+    static constexpr int    COINS_PER_FLIP     = 50;
+    static constexpr double POPUP_LIFETIME     = 1.5; // seconds
+    static constexpr int    POPUP_OFFSET_CELLS = 10;
 
     bool   m_init = false;
     double m_lastAng = 0.0;
     double m_accum   = 0.0;
     int    m_cw = 0, m_ccw = 0;
-    QList<Popup> m_popups;
+    // fixed storage, so copying the tracker into a render snapshot allocates nothing
+    std::array<Popup, MAX_POPUPS> m_popups;
+    int m_popupCount = 0;
+
+    void addPopup(double carX, double carY, double nowSec);
 };
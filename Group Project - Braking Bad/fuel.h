@@ -1,31 +1,20 @@
 #ifndef FUEL_H
 #define FUEL_H
 
-#include <QVector>
 #include <QColor>
-#include <QPainter>
-#include <QHash>
 #include <random>
 #include "constants.h"
-#include "wheel.h"
-
-struct FuelCan {
-    int wx;
-    int wy;
-    bool taken = false;
-};
+#include "terrainstore.h"
+#include "worlditems.h"
 
+// Spawns fuel cans into the WorldItems at the generated edge, further apart as the run goes on.
 class FuelSystem {
 public:
-    QVector<FuelCan> cans;
     int lastPlacedFuelX = 0;
 
     int currentFuelSpacing(double difficulty, double elapsedSeconds) const;
 
-    void maybePlaceFuelAtEdge(int lastTerrainX, const QHash<int,int>& heightAtGX, double difficulty, double elapsedSeconds);
-
-    void drawWorldFuel(QPainter& p, int cameraX, int cameraY) const;
-    void handlePickups(const QList<Wheel*>& wheels, double& fuel);
+    void maybePlaceFuelAtEdge(WorldItems& items, int lastTerrainX, const TerrainStore& terrain, double difficulty, double elapsedSeconds);
 };
 
 #endif // FUEL_H
@@ -0,0 +1,144 @@
+// gridcanvas.cpp
+#include "gridcanvas.h"
+#include <QPainter>
+#include <algorithm>
+
+void GridCanvas::resize(int w, int h) {
+    w = std::max(1, w);
+    h = std::max(1, h);
+    if (w == m_w && h == m_h) return;
+    // RGB32 is what the raster engine blits fastest, and every cell we keep is opaque
+    m_image = QImage(w, h, QImage::Format_RGB32);
+    m_bits = reinterpret_cast<QRgb*>(m_image.bits());
+    m_stride = int(m_image.bytesPerLine() / sizeof(QRgb));
+    m_w = w;
+    m_h = h;
+    m_y0 = 0;
+    m_y1 = h;
+}
+
+GridCanvas GridCanvas::band(int y0, int y1) const {
+    GridCanvas b = *this;
+    b.m_y0 = std::clamp(y0, 0, m_h);
+    b.m_y1 = std::clamp(y1, b.m_y0, m_h);
+    return b;
+}
+
+namespace {
+// c over the opaque colour d
+inline QRgb over(QRgb d, QRgb c) {
+    const int a = qAlpha(c);
+    const int ia = 255 - a;
+    return qRgb((qRed(c)   * a + qRed(d)   * ia) / 255,
+                (qGreen(c) * a + qGreen(d) * ia) / 255,
+                (qBlue(c)  * a + qBlue(d)  * ia) / 255);
+}
+}
+
+QImage GridSprite::image() const {
+    QImage img(w, h, QImage::Format_ARGB32);
+    for (int y = 0; y < h; ++y) {
+        std::copy_n(texels.data() + size_t(y) * w, w, reinterpret_cast<QRgb*>(img.scanLine(y)));
+    }
+    return img;
+}
+
+void GridCanvas::clear(QRgb c) {
+    c |= 0xff000000u;
+    for (int y = m_y0; y < m_y1; ++y) std::fill_n(scanLine(y), m_w, c);
+    m_recording = false;
+}
+
+void GridCanvas::clearTransparent() {
+    for (int y = m_y0; y < m_y1; ++y) std::fill_n(scanLine(y), m_w, QRgb(0));
+    m_recording = true;
+}
+
+GridSprite GridCanvas::takeSprite(int ax, int ay) const {
+    GridSprite s;
+    takeSprite(ax, ay, s);
+    return s;
+}
+
+void GridCanvas::takeSprite(int ax, int ay, GridSprite& s) const {
+    int x0 = m_w, x1 = -1, y0 = m_h, y1 = -1;
+    for (int y = 0; y < m_h; ++y) {
+        const QRgb* row = m_bits + y * m_stride;
+        for (int x = 0; x < m_w; ++x) {
+            if (!qAlpha(row[x])) continue;
+            x0 = std::min(x0, x); x1 = std::max(x1, x);
+            y0 = std::min(y0, y); y1 = std::max(y1, y);
+        }
+    }
+    if (x1 < 0) {
+        s.reset(0, 0);
+        s.ox = s.oy = 0;
+        return;
+    }
+    s.reset(x1 - x0 + 1, y1 - y0 + 1);
+    s.ox = ax - x0;
+    s.oy = ay - y0;
+    for (int y = y0; y <= y1; ++y) {
+        const QRgb* row = m_bits + y * m_stride;
+        std::copy(row + x0, row + x1 + 1, s.texels.begin() + size_t(y - y0) * s.w);
+    }
+}
+
+void GridCanvas::blend(int gx, int gy, QRgb c) {
+    if (unsigned(gx) >= unsigned(m_w) || gy < m_y0 || gy >= m_y1) return;
+    if (qAlpha(c) == 0) return;
+    QRgb& d = m_bits[gy * m_stride + gx];
+    d = (m_recording && qAlpha(d) == 0) ? c : over(d, c);
+}
+
+void GridCanvas::hspan(int gy, int xl, int xr, QRgb c) {
+    if (gy < m_y0 || gy >= m_y1) return;
+    xl = std::max(xl, 0);
+    xr = std::min(xr, m_w - 1);
+    if (xl > xr) return;
+    std::fill_n(scanLine(gy) + xl, xr - xl + 1, c);
+}
+
+void GridCanvas::fillDisc(int gcx, int gcy, int gr, QRgb c) {
+    int x = 0;
+    int y = gr;
+    int d = 1 - gr;
+    while (y >= x) {
+        hspan(gcy + y, gcx - x, gcx + x, c);
+        hspan(gcy - y, gcx - x, gcx + x, c);
+        hspan(gcy + x, gcx - y, gcx + y, c);
+        hspan(gcy - x, gcx - y, gcx + y, c);
+        ++x;
+        if (d < 0) d += 2 * x + 1;
+        else { --y; d += 2 * (x - y) + 1; }
+    }
+}
+
+void GridCanvas::fillRect(int gx, int gy, int w, int h, QRgb c) {
+    const int y0 = std::max(gy, m_y0);
+    const int y1 = std::min(gy + h, m_y1);
+    for (int y = y0; y < y1; ++y) hspan(y, gx, gx + w - 1, c);
+}
+
+void GridCanvas::blit(int gx, int gy, const GridSprite& s) {
+    gx -= s.ox;
+    gy -= s.oy;
+    const int x0 = std::max(0, -gx), x1 = std::min(s.w, m_w - gx);
+    const int y0 = std::max(0, m_y0 - gy), y1 = std::min(s.h, m_y1 - gy);
+    for (int y = y0; y < y1; ++y) {
+        const QRgb* src = s.texels.data() + size_t(y) * s.w;
+        QRgb* dst = scanLine(gy + y) + gx;
+        for (int x = x0; x < x1; ++x) {
+            const int a = qAlpha(src[x]);
+            if (a == 255) dst[x] = src[x];
+            else if (a)   dst[x] = over(dst[x], src[x]);
+        }
+    }
+}
+
+void GridCanvas::present(QPainter& p, int x, int y, int cellSize) const {
+    p.save();
+    p.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    p.drawImage(QRect(x, y, m_w * cellSize, m_h * cellSize), m_image);
+    p.restore();
+}
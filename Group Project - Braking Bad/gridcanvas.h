@@ -0,0 +1,95 @@
+// gridcanvas.h
+#ifndef GRIDCANVAS_H
+#define GRIDCANVAS_H
+
+#include <QImage>
+#include <QColor>
+#include <QRgb>
+#include <vector>
+
+class QPainter;
+
+// Small pre-rendered picture in grid cells, for anything that looks the same
+// every frame. Texels with zero alpha are holes, partial alpha is blended over
+// the canvas and the rest are opaque. (ox, oy) is the anchor cell: the one
+// that lands on the position the sprite is blitted at.
+struct GridSprite {
+    int w = 0, h = 0;
+    int ox = 0, oy = 0;
+    std::vector<QRgb> texels;
+
+    void reset(int width, int height) {
+        w = width; h = height;
+        texels.assign(size_t(w) * h, 0);
+    }
+    void set(int x, int y, QRgb c) { texels[size_t(y) * w + x] = c; }
+    // ARGB32 copy, for drawing on a QPainter
+    QImage image() const;
+};
+
+// Frame buffer with one texel per grid cell. World drawing writes packed
+// colours straight into the scanlines; the finished frame reaches the screen
+// as one nearest-neighbour blit instead of a QPainter::fillRect per cell.
+//
+// A band is a view of some rows of the same buffer that clips everything to
+// them, so separate bands can be drawn from separate threads.
+class GridCanvas {
+public:
+    // w x h cells; the buffer is kept when the size does not change
+    void resize(int w, int h);
+    // rows y0 .. y1-1, sharing this canvas' texels; valid until the next resize
+    GridCanvas band(int y0, int y1) const;
+    // rows writes are clipped to: all of them, or a band's
+    int clipTop() const    { return m_y0; }
+    int clipBottom() const { return m_y1; }
+
+    // fills the clip rows
+    void clear(QRgb c);
+    // Starts recording a sprite: every cell becomes a hole, and translucent
+    // colours plotted onto a hole are kept as they are instead of blended, so
+    // they still blend with whatever the sprite is later blitted over.
+    // clear() ends recording.
+    void clearTransparent();
+    // the drawn cells, trimmed to their bounding box, anchored at (ax, ay)
+    GridSprite takeSprite(int ax, int ay) const;
+    // the same, written into out so its texel buffer is reused
+    void takeSprite(int ax, int ay, GridSprite& out) const;
+
+    int width()  const { return m_w; }
+    int height() const { return m_h; }
+    QRgb* scanLine(int gy) { return m_bits + gy * m_stride; }
+    const QImage& image() const { return m_image; }
+
+    // opaque cell; cells off the canvas are dropped
+    void plot(int gx, int gy, QRgb c) {
+        if (unsigned(gx) >= unsigned(m_w) || gy < m_y0 || gy >= m_y1) return;
+        m_bits[gy * m_stride + gx] = c;
+    }
+    // translucent colours (star twinkle, shadows) are blended over the cell
+    void plot(int gx, int gy, const QColor& c) {
+        if (c.alpha() == 255) plot(gx, gy, c.rgb());
+        else blend(gx, gy, c.rgba());
+    }
+    void blend(int gx, int gy, QRgb c);
+    // cells xl..xr of row gy, clipped
+    void hspan(int gy, int xl, int xr, QRgb c);
+    // filled midpoint circle of radius gr around (gcx, gcy), clipped
+    void fillDisc(int gcx, int gcy, int gr, QRgb c);
+    // w x h cells with the top-left at (gx, gy), clipped
+    void fillRect(int gx, int gy, int w, int h, QRgb c);
+    // draws the sprite with its anchor at (gx, gy), clipped
+    void blit(int gx, int gy, const GridSprite& s);
+
+    // draws the canvas with its first cell at (x, y), cellSize screen pixels per cell
+    void present(QPainter& p, int x, int y, int cellSize) const;
+
+private:
+    QImage m_image;
+    QRgb*  m_bits = nullptr;
+    int    m_w = 0, m_h = 0;
+    int    m_stride = 0;   // in texels
+    int    m_y0 = 0, m_y1 = 0;
+    bool   m_recording = false;
+};
+
+#endif // GRIDCANVAS_H
@@ -0,0 +1,11 @@
+# gridrender.pri
+# Links a target against the gridrender static library built alongside it.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH  += $$PWD
+
+win32-msvc*: GRIDRENDER_LIB = $$OUT_PWD/gridrender.lib
+else:        GRIDRENDER_LIB = $$OUT_PWD/libgridrender.a
+
+LIBS += -L$$OUT_PWD -lgridrender
+PRE_TARGETDEPS += $$GRIDRENDER_LIB
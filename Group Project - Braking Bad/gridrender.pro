@@ -0,0 +1,23 @@
+# gridrender.pro
+# Grid-resolution drawing: the cell canvas, sprite cache, polygon fill and
+# terrain shading. Used by the game, and by simrun's shading benchmark.
+
+QT       = core gui
+CONFIG   += c++17 staticlib
+
+TARGET = gridrender
+TEMPLATE = lib
+DESTDIR = $$OUT_PWD
+OBJECTS_DIR = .obj/gridrender
+
+HEADERS += \
+    gridcanvas.h \
+    polygonfill.h \
+    spritecache.h \
+    terrainshade.h
+
+SOURCES += \
+    gridcanvas.cpp \
+    polygonfill.cpp \
+    spritecache.cpp \
+    terrainshade.cpp
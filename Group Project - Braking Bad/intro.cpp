@@ -1,5 +1,6 @@
 // intro.cpp
 #include "intro.h"
+#include "terrainshade.h"
 #include <QPainter>
 #include <QMouseEvent>
 #include <QImage>
@@ -29,17 +30,13 @@ IntroScreen::IntroScreen(QWidget* parent, int levelIndex) : QWidget(parent) {
 
             const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), 0.02f) * STEP);
 
-            Line seg(m_lastX, m_lastY, m_lastX + STEP, newY);
-            m_lines.append(seg);
-
-            rasterizeSegmentToHeightMapWorld(seg.getX1(), m_lastY, seg.getX2(), newY);
+            m_terrain.append(Line(m_lastX, m_lastY, m_lastX + STEP, newY));
 
             m_lastY = newY;
             m_lastX += STEP;
 
-            if (m_lines.size() > (width() / STEP) * 3) {
-                m_lines.removeFirst();
-                pruneHeightMap();
+            if (m_terrain.segmentCount() > (width() / STEP) * 3) {
+                m_terrain.evictFront();
             }
 
             m_difficulty += DIFF_INC;
@@ -56,15 +53,12 @@ IntroScreen::IntroScreen(QWidget* parent, int levelIndex) : QWidget(parent) {
 
         const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), 0.02f) * STEP);
 
-        Line seg(i - STEP, m_lastY, i, newY);
-        m_lines.append(seg);
-
-        rasterizeSegmentToHeightMapWorld(seg.getX1(), m_lastY, seg.getX2(), newY);
+        m_terrain.append(Line(i - STEP, m_lastY, i, newY));
 
         m_lastY = newY;
         m_difficulty += DIFF_INC;
     }
-    m_lastX = STEP * m_lines.size();
+    m_lastX = STEP * m_terrain.segmentCount();
 
     m_timer.start(16);
 }
@@ -101,10 +95,9 @@ void IntroScreen::maybeSpawnCloud() {
     if (dist(m_rng) > Constants::CLOUD_PROBABILITY[level_index]) return;
 
     int gx = m_lastX / PIXEL_SIZE;
-    auto it = m_heightAtGX.constFind(gx);
-    if (it == m_heightAtGX.constEnd()) return;
+    if (!m_terrain.hasHeight(gx)) return;
 
-    int gyGround = it.value();
+    int gyGround = m_terrain.heightAt(gx);
 
     auto mix = [](quint32 v, int shift, int span, int base){
         return base + int(((v >> shift) % quint32(span)));
@@ -128,7 +121,7 @@ void IntroScreen::maybeSpawnCloud() {
 
     m_lastCloudSpawnX = m_lastX;
 
-    int leftLimit = (m_lines.isEmpty() ? 0 : m_lines.first().getX1()) - width()*2;
+    int leftLimit = (m_terrain.isEmpty() ? 0 : m_terrain.front().getX1()) - width()*2;
     for (int i = 0; i < m_clouds.size(); ) {
         if (m_clouds[i].wx < leftLimit) m_clouds.removeAt(i);
         else ++i;
@@ -200,10 +193,7 @@ void IntroScreen::drawStars(QPainter& p) {
                 int wgx = bx * BLOCK + idist(rng);
                 int wgy = by * BLOCK + idist(rng);
 
-                int groundGy = 0;
-                auto it = m_heightAtGX.constFind(wgx);
-                if (it != m_heightAtGX.constEnd()) groundGy = it.value();
-                else groundGy = 10000;
+                int groundGy = m_terrain.heightAt(wgx, 10000);
 
                 if (wgy < groundGy - 8) {
                     int sgx = wgx - camGX;
@@ -525,10 +515,9 @@ void IntroScreen::drawFilledTerrain(QPainter& p) {
 
     for (int sgx = 0; sgx <= gridW(); ++sgx) {
         const int worldGX = sgx + camGX;
-        auto it = m_heightAtGX.constFind(worldGX);
-        if (it == m_heightAtGX.constEnd()) continue;
+        if (!m_terrain.hasHeight(worldGX)) continue;
 
-        const int groundWorldGY = it.value();
+        const int groundWorldGY = m_terrain.heightAt(worldGX);
         int startScreenGY = groundWorldGY + camGY;
         if (startScreenGY < 0) startScreenGY = 0;
         if (startScreenGY >= gridH()) continue;
@@ -567,24 +556,8 @@ void IntroScreen::drawFilledTerrain(QPainter& p) {
 }
 
 QColor IntroScreen::grassShadeForBlock(int worldGX, int worldGY, bool greenify) const {
-    auto hash2D = [](int x, int y)->quint32{
-        quint32 h = 120003212u;
-        h ^= quint32(x); h *= 16777619u;
-        h ^= quint32(y); h *= 16777619u;
-        return (h ^ x) / (h ^ y) + (x * y) - (3 * x*x + 4 * y*y);
-    };
-
-    const int bx = worldGX / SHADING_BLOCK;
-    const int by = worldGY / SHADING_BLOCK;
-    const quint32 h = hash2D(bx, by);
-
-    if (greenify) {
-        const int idxG = int(h % m_grassPalette.size());
-        return m_grassPalette[level_index][idxG];
-    } else {
-        const int idxD = int(h % m_dirtPalette.size());
-        return m_dirtPalette[level_index][idxD];
-    }
+    // same blocks and palettes as the game's terrain
+    return QColor(TerrainShade::blockColor(level_index, worldGX, worldGY, greenify));
 }
 
 void IntroScreen::plotGridPixel(QPainter& p, int gx, int gy, const QColor& c) {
@@ -592,44 +565,6 @@ void IntroScreen::plotGridPixel(QPainter& p, int gx, int gy, const QColor& c) {
     p.fillRect(gx * PIXEL_SIZE, gy * PIXEL_SIZE, PIXEL_SIZE, PIXEL_SIZE, c);
 }
 
-void IntroScreen::rasterizeSegmentToHeightMapWorld(int x1,int y1,int x2,int y2){
-    if (x2 < x1) { std::swap(x1,x2); std::swap(y1,y2); }
-
-    const int gx1 = x1 / PIXEL_SIZE;
-    const int gx2 = x2 / PIXEL_SIZE;
-
-    if (x2 == x1) {
-        const int gy = int(std::floor(y1 / double(PIXEL_SIZE) + 0.5));
-        m_heightAtGX.insert(gx1, gy);
-        return;
-    }
-
-    const double dx = double(x2 - x1);
-    double dy = double(y2 - y1);
-
-    for (int gx = gx1; gx <= gx2; ++gx) {
-        const double wx = gx * double(PIXEL_SIZE);
-        double t = (wx - x1) / dx;
-        t = std::clamp(t, 0.0, 1.0);
-        const double wy = y1 + t * dy;
-        const int gy = int(std::floor(wy / double(PIXEL_SIZE) + 0.5));
-        m_heightAtGX.insert(gx, gy);
-    }
-}
-
-void IntroScreen::pruneHeightMap() {
-    if (m_lines.isEmpty()) return;
-    const int keepFromGX = (m_lines.first().getX1() / PIXEL_SIZE) - 4;
-
-    QList<int> toRemove;
-    toRemove.reserve(m_heightAtGX.size());
-
-    for (auto it = m_heightAtGX.constBegin(); it != m_heightAtGX.constEnd(); ++it) {
-        if (it.key() < keepFromGX) toRemove.append(it.key());
-    }
-    for (int k : toRemove) m_heightAtGX.remove(k);
-}
-
 void IntroScreen::ensureAheadTerrain(int worldX) {
     while (m_lastX < worldX) {
         m_slope += (0.5f - float(m_lastY) / std::max(1,height())) * m_difficulty;
@@ -637,17 +572,13 @@ void IntroScreen::ensureAheadTerrain(int worldX) {
 
         const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), 0.02f) * STEP);
 
-        Line seg(m_lastX, m_lastY, m_lastX + STEP, newY);
-        m_lines.append(seg);
-
-        rasterizeSegmentToHeightMapWorld(seg.getX1(), m_lastY, seg.getX2(), newY);
+        m_terrain.append(Line(m_lastX, m_lastY, m_lastX + STEP, newY));
 
         m_lastY = newY;
         m_lastX += STEP;
 
-        if (m_lines.size() > (width() / STEP) * 3) {
-            m_lines.removeFirst();
-            pruneHeightMap();
+        if (m_terrain.segmentCount() > (width() / STEP) * 3) {
+            m_terrain.evictFront();
         }
 
         m_difficulty += DIFF_INC;
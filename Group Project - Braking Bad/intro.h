@@ -4,11 +4,11 @@
 
 #include <QWidget>
 #include <QTimer>
-#include <QHash>
 #include <QColor>
 #include <QVector>
 #include <QList>
 #include "line.h"
+#include "terrainstore.h"
 #include "constants.h"
 #include <QSettings>
 #include <random>
@@ -47,8 +47,6 @@ private:
     void drawBackground(QPainter& p);
     void drawFilledTerrain(QPainter& p);
     void plotGridPixel(QPainter& p, int gx, int gy, const QColor& c);
-    void rasterizeSegmentToHeightMapWorld(int x1, int y1, int x2, int y2);
-    void pruneHeightMap();
     void ensureAheadTerrain(int worldX);
     QColor grassShadeForBlock(int worldGX, int worldGY, bool greenify) const;
 
@@ -78,8 +76,7 @@ private:
     QTimer m_timer;
     double m_scrollX = 0.0;
 
-    QList<Line> m_lines;
-    QHash<int,int> m_heightAtGX;
+    TerrainStore m_terrain;
     QVector<Cloud> m_clouds;
 
     int m_lastCloudSpawnX = 0;
@@ -0,0 +1,88 @@
+// itemrenderer.cpp
+#include "itemrenderer.h"
+#include "constants.h"
+
+const std::array<const GridSprite& (*)(), WorldItems::KIND_COUNT> ItemRenderer::SPRITES = {{
+    &ItemRenderer::coinSprite,   // Coin
+    &ItemRenderer::canSprite,    // FuelCan
+}};
+
+namespace {
+// a coin centred on (gcx, gcy): rim, two fills and a glint
+void drawCoin(GridCanvas& p, int gcx, int gcy) {
+    const QColor rim  (195,140,40);
+    const QColor fill (250,204,77);
+    const QColor fill2(245,184,50);
+    const QColor shine(255,255,220);
+    const int r = Constants::COIN_RADIUS_CELLS;
+
+    p.fillDisc(gcx, gcy, r, rim.rgb());
+    if (r-1 > 0) {
+        p.fillDisc(gcx, gcy, r-1, fill.rgb());
+    }
+    if (r-2 > 0) {
+        p.fillDisc(gcx, gcy, r-2, fill2.rgb());
+    }
+
+    p.plot(gcx-1, gcy-r+1, shine);
+    p.plot(gcx,   gcy-r+1, shine);
+}
+}
+
+const GridSprite& ItemRenderer::coinSprite() {
+    static const GridSprite sprite = [] {
+        const int r = Constants::COIN_RADIUS_CELLS;
+        GridCanvas c;
+        c.resize(2 * r + 1, 2 * r + 1);
+        c.clearTransparent();
+        drawCoin(c, r, r);
+        return c.takeSprite(r, r);
+    }();
+    return sprite;
+}
+
+const GridSprite& ItemRenderer::canSprite() {
+    static const GridSprite sprite = [] {
+        QColor body(230, 60, 60);
+        QColor cap(230,230,230);
+        QColor label(255,200,50);
+        QColor shadow(0,0,0,90);
+
+        GridCanvas p;
+        p.resize(6, 6);
+        p.clearTransparent();
+
+        p.plot(2,1,shadow);
+        p.plot(5,2,shadow);
+
+        p.plot(1,0,cap);
+        p.plot(2,0,cap);
+
+        for (int y=1; y<=5; ++y) {
+            for (int x=0; x<=4; ++x) {
+                p.plot(x,y,body);
+            }
+        }
+
+        for (int x=1; x<=3; ++x) {
+            p.plot(x,3,label);
+        }
+        return p.takeSprite(2, 3);
+    }();
+    return sprite;
+}
+
+void ItemRenderer::draw(GridCanvas& g, const WorldItems& items, int cameraX, int cameraY) {
+    const int camGX = cameraX / Constants::PIXEL_SIZE;
+    const int camGY = cameraY / Constants::PIXEL_SIZE;
+    // sprites are a few cells across; this margin keeps the ones half in view
+    const int margin = 8 * Constants::PIXEL_SIZE;
+    const auto [first, last] = items.range(camGX * Constants::PIXEL_SIZE - margin,
+                                           (camGX + g.width()) * Constants::PIXEL_SIZE + margin);
+
+    for (int i = first; i < last; ++i) {
+        const int gx = (items.x(i) / Constants::PIXEL_SIZE) - camGX;
+        const int gy = (items.y(i) / Constants::PIXEL_SIZE) + camGY;
+        g.blit(gx, gy, SPRITES[size_t(items.kind(i))]());
+    }
+}
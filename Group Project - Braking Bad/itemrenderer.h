@@ -0,0 +1,24 @@
+// itemrenderer.h
+#ifndef ITEMRENDERER_H
+#define ITEMRENDERER_H
+
+#include <array>
+#include "gridcanvas.h"
+#include "worlditems.h"
+
+// Draws the WorldItems pools into the grid canvas. The item store itself is
+// plain data in the simulation core; what each kind looks like lives here,
+// one sprite per ItemKind, rasterized on first use.
+class ItemRenderer {
+public:
+    // sprite of each kind, anchored on the pickup point
+    static const std::array<const GridSprite& (*)(), WorldItems::KIND_COUNT> SPRITES;
+
+    static const GridSprite& coinSprite();
+    static const GridSprite& canSprite();
+
+    // the items within the canvas, camera as in the other world layers
+    static void draw(GridCanvas& g, const WorldItems& items, int cameraX, int cameraY);
+};
+
+#endif // ITEMRENDERER_H
@@ -1,22 +1,35 @@
 #include "line.h"
 #include <cmath>
+#include <algorithm>
+
+Line::Line() : Line(0, 0, 0, 0) {}
 
 Line::Line(int x1, int y1, int x2, int y2)
     : m_x1(x1), m_y1(y1), m_x2(x2), m_y2(y2) {
-    if (m_x2 - m_x1 == 0) {
-        m_slope = 1e9;
+    const double dx = m_x2 - m_x1;
+    const double dy = m_y2 - m_y1;
+    m_length = std::sqrt(dx * dx + dy * dy);
+    if (m_length > 0.0) {
+        m_invLength = 1.0 / m_length;
+        m_tx = dx * m_invLength;
+        m_ty = dy * m_invLength;
     } else {
-        m_slope = static_cast<double>(m_y2 - m_y1) / static_cast<double>(m_x2 - m_x1);
+        m_invLength = 0.0;
+        m_tx = 1.0;
+        m_ty = 0.0;
     }
-    m_intercept = m_y1 - m_slope * m_x1;
 }
 
 int Line::getX1() const { return m_x1; }
 int Line::getX2() const { return m_x2; }
 int Line::getY1() const {return m_y1; }
 int Line::getY2() const {return m_y2; }
-double Line::getSlope() const { return m_slope; }
-double Line::getIntercept() const { return m_intercept; }
+
+double Line::yAt(double x) const {
+    if (m_x2 == m_x1) return std::min(m_y1, m_y2);
+    const double t = std::clamp((x - m_x1) / (m_x2 - m_x1), 0.0, 1.0);
+    return m_y1 + t * (m_y2 - m_y1);
+}
 
 std::optional<std::array<int, 4>> Line::get(int x1bound, int y1bound, int x2bound, int y2bound, int dx, int dy) const {
     int screen_x1 = m_x1 + dx;
@@ -6,17 +6,31 @@
 
 class Line {
 public:
+    Line();
     Line(int x1, int y1, int x2, int y2);
     int getX1() const;
     int getX2() const;
     int getY1() const;
     int getY2() const;
-    double getSlope() const;
-    double getIntercept() const;
+
+    // Unit direction from (x1,y1) to (x2,y2) and the unit normal to its left,
+    // which points up (towards -y) for left-to-right terrain. Precomputed so
+    // collision is dot products only; vertical segments are fine.
+    double tangentX() const { return m_tx; }
+    double tangentY() const { return m_ty; }
+    double normalX() const { return m_ty; }
+    double normalY() const { return -m_tx; }
+    double length() const { return m_length; }
+    double invLength() const { return m_invLength; }
+
+    // Height of the segment at world x, clamped to its ends.
+    double yAt(double x) const;
+
     std::optional<std::array<int, 4>> get(int x1bound, int y1bound, int x2bound, int y2bound, int dx, int dy) const;
 private:
     int m_x1, m_y1, m_x2, m_y2;
-    double m_slope, m_intercept;
+    double m_tx, m_ty;
+    double m_length, m_invLength;
 };
 
 #endif // LINE_H
@@ -1,5 +1,6 @@
 #include "mainwindow.h"
 #include "coin.h"
+#include "itemrenderer.h"
 #include "outro.h"
 #include <QSettings>
 #include <QCloseEvent>
@@ -8,12 +9,33 @@
 #include <QPalette>
 #include <QTimer>
 #include <QFont>
+#include <QThread>
 #include <cmath>
+#include <cstdio>
 #include <algorithm>
-#include <map>
-#include <list>
 #include <limits>
 
+namespace {
+// printf-style text written over out's characters, so a HUD string that is
+// redrawn every frame keeps its buffer instead of being built anew
+template <typename... Args>
+void formatInto(QString& out, const char* format, Args... args) {
+    char buf[64];
+    const int n = std::clamp(std::snprintf(buf, sizeof buf, format, args...), 0, int(sizeof buf) - 1);
+    out.resize(n);
+    QChar* d = out.data();
+    for (int i = 0; i < n; ++i) d[i] = QLatin1Char(buf[i]);
+}
+}
+
+QFont MainWindow::hudFont() {
+    QFont f;
+    f.setFamily("Monospace");
+    f.setBold(true);
+    f.setPointSize(12);
+    return f;
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QWidget(parent),
     m_rng(std::random_device{}() ),
@@ -27,6 +49,7 @@ MainWindow::MainWindow(QWidget *parent)
     m_pause->hide();
     connect(m_pause, &PauseOverlay::resumeRequested, this, [this]{
         if (m_pause) m_pause->hide();
+        m_lastFrameNs = -1;
         if (m_timer) m_timer->start();
         setFocus();
     });
@@ -50,6 +73,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_leaderboardWidget, &LeaderboardWidget::closed, this, [this]{
         // Resume game when leaderboard is closed (if we were in-game)
         if (m_timer && !m_intro && !m_outro) {
+            m_lastFrameNs = -1;
             m_timer->start();
         }
         setFocus();
@@ -57,12 +81,29 @@ MainWindow::MainWindow(QWidget *parent)
 
     loadGrandCoins();
 
+    {
+        QSettings s("JU","F1PixelGrid");
+        m_sim.setPhysicsHz(s.value("physicsHz", Constants::PHYSICS_HZ).toInt());
+        m_sim.setSubsteps(s.value("physicsSubsteps", Constants::PHYSICS_SUBSTEPS).toInt());
+        m_logicalW = std::clamp(s.value("logicalWidthCells", Constants::LOGICAL_W_CELLS).toInt(),
+                                Constants::LOGICAL_CELLS_MIN, Constants::LOGICAL_CELLS_MAX);
+        m_logicalH = std::clamp(s.value("logicalHeightCells", Constants::LOGICAL_H_CELLS).toInt(),
+                                Constants::LOGICAL_CELLS_MIN, Constants::LOGICAL_CELLS_MAX);
+    }
+    m_sim.setViewport(viewW(), viewH());
+    m_terrainTiles.setDepth(gridH() + 1);
+    // prepareStars() spans at most size / STAR_BLOCK + 4 blocks each way
+    m_starCols = gridW() / STAR_BLOCK + 5;
+    m_starRows = gridH() / STAR_BLOCK + 5;
+    m_starBlocks.assign(size_t(m_starCols) * m_starRows, StarBlock());
+    // these run on the simulation worker; the edits are applied when its snapshot is adopted
+    m_sim.onSegmentAppended = [this](const Line& segment, float slope){ m_simOut.terrainEdits.append({segment, slope, false}); };
+    m_sim.onSegmentEvicted  = [this]{ m_simOut.terrainEdits.append({Line(), 0.0f, true}); };
+
     m_timer = new QTimer(this);
     connect(m_timer, &QTimer::timeout, this, &MainWindow::gameLoop);
-    m_timer->start(10);
+    m_timer->start(Constants::FRAME_INTERVAL_MS);
 
-    m_camX = m_cameraX;
-    m_camY = m_cameraY;
     m_clock.start();
 
     m_showGrid = false;
@@ -95,7 +136,9 @@ MainWindow::MainWindow(QWidget *parent)
 }
 
 MainWindow::~MainWindow() {
-    qDeleteAll(m_wheels);
+    joinSimulation();
+    m_sim.onSegmentAppended = nullptr;
+    m_sim.onSegmentEvicted = nullptr;
 }
 
 
@@ -107,256 +150,141 @@ void MainWindow::resizeEvent(QResizeEvent *e) {
 }
 
 
-void MainWindow::generateInitialTerrain() {
-    int currentWorldX= m_lastX;
-    m_lastY = height() / 2;
-
-    for (int i = Constants::STEP; i <= width() + Constants::STEP; i += Constants::STEP) {
-
-        m_slope += (m_dist(m_rng) - (1 - m_terrain_height/100) * static_cast<float>(m_lastY) / height()) * m_difficulty;
-        m_slope = std::clamp(m_slope, -(float)Constants::MAX_SLOPE[level_index], (float)Constants::MAX_SLOPE[level_index]);
-        const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), m_irregularity) * Constants::STEP);
-
-        Line seg(i - Constants::STEP, m_lastY, i, newY);
-        m_lines.append(seg);
-        rasterizeSegmentToHeightMapWorld(seg.getX1(), m_lastY, seg.getX2(), newY);
-
-        int midX = seg.getX1();
-        int groundGy = groundGyNearestGX(midX / Constants::PIXEL_SIZE); 
-        m_propSys.maybeSpawnProp(currentWorldX, groundGy, level_index, m_slope, m_rng);
-
-        m_lastY = newY;
-        m_lastX = i;
+void MainWindow::onSegmentAppended(const Line& segment, float slope) {
+    const int currentWorldX = segment.getX1();
+    int gx = currentWorldX / Constants::PIXEL_SIZE;
+    int groundGy = m_terrain.nearestHeight(gx);
+    m_propSys.maybeSpawnProp(currentWorldX, groundGy, level_index, slope, m_rng);
+    maybeSpawnCloud(segment.getX2());
 
-        m_difficulty += Constants::DIFFICULTY_INCREMENT[level_index];
-        m_irregularity += Constants::IRREGULARITY_INCREMENT[level_index];
-        if(m_terrain_height < 0.5) m_terrain_height += Constants::TERRAIN_HEIGHT_INCREMENT[level_index];
-    }
-    m_lastX = Constants::STEP * m_lines.size();
+    m_terrainTiles.extend(m_terrain);
+    m_terrainTiles.evictBefore(m_terrain.front().getX1() / Constants::PIXEL_SIZE);
+    m_propSys.prune(m_terrain.front().getX1());
 }
 
+void MainWindow::joinSimulation() {
+    m_simWorker.wait();
+}
 
-void MainWindow::createCar() {
-    Wheel* w1 = new Wheel(Constants::WHEEL_REAR_X,  Constants::WHEEL_REAR_Y,  Constants::WHEEL_REAR_R);
-    Wheel* w2 = new Wheel(Constants::WHEEL_FRONT_X, Constants::WHEEL_FRONT_Y, Constants::WHEEL_FRONT_R);
-    Wheel* w3 = new Wheel(Constants::WHEEL_MID_X,   Constants::WHEEL_MID_Y,   Constants::WHEEL_MID_R);
-
-    w1->attach(w2); w3->attach(w2); w1->attach(w3);
-    m_wheels.append(w1); m_wheels.append(w2); m_wheels.append(w3);
-
-    CarBody* body = new CarBody();
-    body->addPoints(Constants::CAR_BODY_POINTS);
-    body->addHitbox(Constants::CAR_HITBOX_POINTS);
-    body->addKillSwitches(Constants::CAR_KILL_POINTS);
-
-    body->addWheel(w1); body->addWheel(w2); body->addWheel(w3);
-
-    body->addAttachment(Constants::CAR_GLASS_POINTS, Constants::CAR_GLASS_COLOR);
-    body->addAttachment(Constants::CAR_HANDLE_POINTS, Constants::CAR_HANDLE_COLOR);
+void MainWindow::adoptSnapshot() {
+    std::swap(m_frame, m_simOut);
+    m_simPending = false;
+
+    // replayed in the simulation's order, so the decorations see the same
+    // terrain they would have seen from inside appendSegment()
+    for (const RenderSnapshot::TerrainEdit& e : m_frame.terrainEdits) {
+        if (e.evict) {
+            m_terrain.evictFront();
+        } else {
+            m_terrain.append(e.segment);
+            onSegmentAppended(e.segment, e.slope);
+        }
+    }
+    m_frame.terrainEdits.clear();
 
-    body->finish();
-    m_bodies.append(body);
+    m_cameraX = int(std::lround(m_frame.cameraX));
+    m_cameraY = int(std::lround(m_frame.cameraY));
 }
 
 
 void MainWindow::gameLoop() {
     const qint64 now = m_clock.nsecsElapsed();
-    static qint64 prev = now;
-    const qint64 dtns = now - prev;
-    prev = now;
-    const double dt = std::clamp(dtns / 1e9, 0.001, 0.033);
-
-    m_elapsedSeconds += dt;
-    double fuelBefore = m_fuel;
-    int coinsBefore = m_coinCount;
-    double avgX = 0.0, avgY = 0.0;
-    if (!m_wheels.isEmpty()) {
-        for (const Wheel* w : m_wheels) { avgX += w->x; avgY += w->y; }
-        avgX /= m_wheels.size();
-        avgY /= m_wheels.size();
-    }
-
-    double dx = std::max(0.0, avgX - m_lastScoreX);
-    m_totalDistanceCells += dx / double(Constants::PIXEL_SIZE);
-    m_lastScoreX = avgX;
-
-    m_score = int(std::llround(Constants::SCORE_DIST_PER_CELL * m_totalDistanceCells +
-                               Constants::SCORE_PER_COIN * m_coinCount +
-                               Constants::SCORE_PER_NITRO * m_nitroUses));
-
-    double bodyX = (!m_bodies.isEmpty()) ? m_bodies.first()->getX() : avgX;
-    double bodyY = (!m_bodies.isEmpty()) ? m_bodies.first()->getY() : avgY;
-    const double targetX = bodyX - 200.0;
-    const double targetY = -bodyY + height() / 2.0;
-    updateCamera(targetX, targetY, dt);
-    m_cameraX = int(std::lround(m_camX));
-    m_cameraY = int(std::lround(m_camY));
-    double angleRad = 0.0;
-    if (m_wheels.size() >= 2) {
-        const double dx = (m_wheels[1]->x - m_wheels[0]->x);
-        const double dy = (m_wheels[1]->y - m_wheels[0]->y);
-        angleRad = std::atan2(dy, dx);
-    }
-    double carX = (!m_bodies.isEmpty()) ? m_bodies.first()->getX() : avgX;
-    double carY = (!m_bodies.isEmpty()) ? m_bodies.first()->getY() : avgY;
-
-    m_flip.update(angleRad, carX, carY, m_elapsedSeconds, [this](int bonus){ m_coinCount += bonus; });  
-
-    const int viewRightX = m_cameraX + width();
-    const int marginPx   = Constants::COIN_SPAWN_MARGIN_CELLS * Constants::PIXEL_SIZE;
-    const int offRightX  = viewRightX + marginPx;
-    const int maxStreamWidthPx =
-        (Constants::COIN_GROUP_MAX - 1) * Constants::COIN_GROUP_STEP_MAX * Constants::PIXEL_SIZE;
-    ensureAheadTerrain(offRightX + maxStreamWidthPx + Constants::PIXEL_SIZE * 20);
-
-    m_coinSys.maybePlaceCoinStreamAtEdge(
-        m_elapsedSeconds, m_cameraX, width(), m_heightAtGX, m_lastX, m_rng, m_dist);
-
-    m_nitroSys.update(
-        m_nitroKey, m_fuel, m_elapsedSeconds, avgX,
-        [this](int gx){ return this->groundGyNearestGX(gx); },
-        [this](double wx){ return this->terrainTangentAngleAtX(wx); }
-        );
-
-    if (m_nitroSys.active && !m_prevNitroActive) ++m_nitroUses;
-    m_prevNitroActive = m_nitroSys.active;
-
-    const bool allowInput = (m_fuel > 0.0);
-    bool accelDrive = false, brakeDrive = false, nitroDrive = false;
-
-    if (m_nitroSys.active && allowInput) {
-        accelDrive = false; brakeDrive = false; nitroDrive = true;
-    } else {
-        nitroDrive = false;
-        bool bothKeys = m_accelerating && m_braking;
-        if (allowInput) {
-            if (bothKeys) { accelDrive = true; brakeDrive = true; }
-            else { accelDrive = m_accelerating; brakeDrive = m_braking; }
-        } else { accelDrive = false; brakeDrive = false; }
-    }
-
-    for (Wheel* w : m_wheels) w->simulate(level_index, m_lines, accelDrive, brakeDrive, nitroDrive);
-    for (CarBody* b : m_bodies) b->simulate(level_index, m_lines, accelDrive, brakeDrive);
-
-    m_nitroSys.applyThrust(m_wheels);
-
-    if (m_fuel > 0.0) {
-        double baseBurn = Constants::FUEL_BASE_BURN_PER_SEC * dt;
-        double extra = 0.0;
-        if (m_accelerating) extra = std::max(0.0, averageSpeed()) * Constants::FUEL_EXTRA_PER_SPEED * dt;
-        double burnMult = m_nitroSys.active ? 3.0 : 1.0;
-        m_fuel = std::max(0.0, m_fuel - burnMult * (baseBurn + extra));
-    }
-
-    const int minX = leftmostTerrainX();
-    for (Wheel* w : m_wheels) {
-        if (w->x < minX) { w->x = minX; w->m_vx = 0; }
-    }
-
-    if (!isFullyUpsideDown()) {
-        m_fuelSys.handlePickups(m_wheels, m_fuel);
-        m_coinSys.handlePickups(m_wheels, m_coinCount);
-    }
-    if (m_coinCount > coinsBefore) m_media->coinPickup();
-    if ((m_fuel - fuelBefore) > 1e-3 && !m_suppressFuelSfx) m_media->fuelPickup();
-    {
-        auto ptSegDist2 = [](double px, double py, const Line& ln)->double {
-            double x1 = ln.getX1(), y1 = ln.getY1();
-            double x2 = ln.getX2(), y2 = ln.getY2();
-            double vx = x2 - x1,   vy = y2 - y1;
-            double wx = px - x1,   wy = py - y1;
-            double len2 = vx*vx + vy*vy;
-            double t = (len2 > 0.0) ? (wx*vx + wy*vy) / len2 : 0.0;
-            if (t < 0.0) t = 0.0; else if (t > 1.0) t = 1.0;
-            double cx = x1 + t*vx, cy = y1 + t*vy;
-            double dx = px - cx,   dy = py - cy;
-            return dx*dx + dy*dy;
-        };
-
-        const double R2 = double(Constants::COIN_PICKUP_RADIUS) * double(Constants::COIN_PICKUP_RADIUS);
-
-        for (auto& coin : m_coinSys.coins) {
-            if (coin.taken) continue;
-            bool hit = false;
-
-            for (CarBody* body : m_bodies) {
-                const auto edges = body->getLines();
-                for (const Line& ln : edges) {
-                    if (ptSegDist2(coin.cx, coin.cy, ln) <= R2) {
-                        hit = true;
-                        break;
-                    }
-                }
-
-                if (!hit) {
-                    const auto bodyPoints = body->get(0, 0);
-                    QPolygon polygon;
-                    for (const QPoint& p : bodyPoints)
-                        polygon << QPoint(p.x(), p.y());
-                    if (polygon.containsPoint(QPoint(coin.cx, coin.cy), Qt::OddEvenFill))
-                        hit = true;
-                }
-
-                if (hit) break;
-            }
-
-            if (hit) {
-                coin.taken = true;
-                ++m_coinCount;
-            }
-        }
-
+    if (m_lastFrameNs < 0) m_lastFrameNs = now;
+    const double frameSeconds = std::max<qint64>(0, now - m_lastFrameNs) / 1e9;
+    m_lastFrameNs = now;
+
+    // the ticks started last frame are drawn this frame
+    joinSimulation();
+    if (m_simPending) {
+        const double fuelBefore = m_frame.fuel;
+        const int coinsBefore = m_frame.coinCount;
+        adoptSnapshot();
+
+        if (m_frame.coinCount > coinsBefore) m_media->coinPickup();
+        if ((m_frame.fuel - fuelBefore) > 1e-3 && !m_suppressFuelSfx) m_media->fuelPickup();
     }
 
-    const bool fuelEmpty = (m_fuel <= 0.0);
-    const bool roofHit   = !m_bodies[0]->isAlive();
-
-    if (roofHit && !m_roofCrashLatched) {
-        m_roofCrashLatched = true;
-        if (!m_bodies.isEmpty() && m_bodies[0]->isAlive()) {
-            m_bodies[0]->kill();
-        }
-    }
-
-    if (fuelEmpty || m_roofCrashLatched) {
+    if (m_frame.over) {
         armGameOver();
     } else {
         disarmGameOver();
     }
 
-    update();
-}
+    m_sim.setControls({m_accelerating, m_braking, m_nitroKey});
+    m_simPending = true;
+    m_simFrameSeconds = frameSeconds;
+    m_simWorker.start();
 
-int MainWindow::leftmostTerrainX() const {
-    if (m_lines.isEmpty()) return 0;
-    return m_lines.first().getX1();
+    update();
 }
 
 void MainWindow::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
     QPainter p(this);
-    p.setRenderHint(QPainter::Antialiasing, true);
     p.setPen(Qt::NoPen);
 
+    // from here on the painter works in logical pixels
+    const double fit = std::min(double(width()) / viewW(), double(height()) / viewH());
+    const double scale = fit >= 1.0 ? std::floor(fit) : fit;
+    p.fillRect(rect(), Qt::black);
+    p.translate(std::round((width() - viewW() * scale) / 2), std::round((height() - viewH() * scale) / 2));
+    p.scale(scale, scale);
+    p.setClipRect(0, 0, viewW(), viewH());
+
     const int camGX = m_cameraX / Constants::PIXEL_SIZE;
     const int camGY = m_cameraY / Constants::PIXEL_SIZE;
     const int offX  = -(m_cameraX - camGX * Constants::PIXEL_SIZE);
     const int offY  =  (m_cameraY - camGY * Constants::PIXEL_SIZE);
 
+    // the world is drawn cell by cell into the grid canvas, then blitted once
+    GridCanvas& g = m_canvas;
+    g.resize(gridW() + 1, gridH() + 1);
+    prepareFrame();
+
+    const int rows = g.height();
+    const int bands = std::clamp(rows / MIN_BAND_ROWS, 1, QThread::idealThreadCount());
+    if (bands == 1) {
+        renderBand(g);
+    } else {
+        // band 0 is drawn here while the band workers draw the rest
+        if (m_bands.size() != bands) m_bands.resize(bands);
+        for (int i = 0; i < bands; ++i) m_bands[i] = g.band(rows * i / bands, rows * (i + 1) / bands);
+        while (int(m_bandWorkers.size()) < bands - 1) {
+            const int band = int(m_bandWorkers.size()) + 1;
+            m_bandWorkers.push_back(std::make_unique<WorkerThread>([this, band] { renderBand(m_bands[band]); }));
+        }
+        for (int i = 1; i < bands; ++i) m_bandWorkers[i - 1]->start();
+        renderBand(m_bands[0]);
+        for (int i = 1; i < bands; ++i) m_bandWorkers[i - 1]->wait();
+    }
+
+    g.present(p, offX, offY, Constants::PIXEL_SIZE);
+
     p.save();
     p.translate(offX, offY);
-
     if (m_showGrid) { drawGridOverlay(p); }
-    drawStars(p);
-    drawClouds(p);
-    drawFilledTerrain(p);
-    m_propSys.draw(p, m_cameraX, m_cameraY, width(), height(), m_heightAtGX);
-    m_fuelSys.drawWorldFuel(p, m_cameraX, m_cameraY);
-    m_coinSys.drawWorldCoins(p, m_cameraX, m_cameraY, gridW(), gridH());
-    m_nitroSys.drawFlame(p, m_wheels, m_cameraX, m_cameraY, width(), height());
-
-    for (const Wheel* wheel : m_wheels) {
-        if (auto info = wheel->get(0, 0, width(), height(), -m_cameraX, m_cameraY)) {
+    p.restore();
+
+    // the HUD is pinned to the screen rather than to the camera, so it stays on QPainter
+    drawHUDFuel(p);
+    drawHUDCoins(p);
+    drawHUDNitro(p);
+    drawHUDFlips(p);
+    drawHUDDistance(p);
+    drawHUDScore(p);
+    m_keylog.draw(p, viewW(), viewH(), Constants::PIXEL_SIZE);
+}
+
+void MainWindow::prepareFrame() {
+    prepareStars();
+    m_terrainTiles.prepare(m_cameraX / Constants::PIXEL_SIZE, m_cameraY / Constants::PIXEL_SIZE,
+                           m_canvas.width(), m_canvas.height());
+    m_propSys.prepare(m_cameraX, m_cameraY, viewW(), viewH(), m_terrain);
+
+    m_vehicleSprites.clear();
+    m_wheelSprites.nextFrame();
+    for (const WheelPose& wheel : m_frame.wheels) {
+        if (auto info = wheel.get(0, 0, viewW(), viewH(), -m_cameraX, m_cameraY)) {
             const int cx = (*info)[0];
             const int cy = (*info)[1];
             const int r  = (*info)[2];
@@ -364,54 +292,42 @@ void MainWindow::paintEvent(QPaintEvent *event) {
             const int gcx = cx / Constants::PIXEL_SIZE;
             const int gcy = cy / Constants::PIXEL_SIZE;
             const int gr  = r  / Constants::PIXEL_SIZE;
-            drawCircleFilledMidpointGrid(p, gcx, gcy, gr, Constants::WHEEL_COLOR_OUTER);
             const int tyreCells = std::max(1, Constants::TYRE_THICKNESS / Constants::PIXEL_SIZE);
             const int innerR = std::max(1, gr - tyreCells);
-            drawCircleFilledMidpointGrid(p, gcx, gcy, innerR, Constants::WHEEL_COLOR_INNER);
+            m_vehicleSprites.push_back({&wheelSprite(gr, innerR), gcx, gcy});
         }
     }
 
-    for(CarBody* body : m_bodies){
-        auto pts = body->get(-m_cameraX, m_cameraY);
-        QVector<QPoint> normalisedPoints;
-        normalisedPoints.reserve(pts.size());
-        for(auto p2 : pts){
-            normalisedPoints.append(QPoint(p2.x() / Constants::PIXEL_SIZE, p2.y() / Constants::PIXEL_SIZE));
-        }
-        fillPolygon(p, normalisedPoints, Constants::CAR_COLOR);
-
-        auto attach = body->getAttachments(-m_cameraX, m_cameraY);
-        for (const auto& ap : attach) {
-            QVector<QPoint> norm;
-            norm.reserve(ap.first.size());
-            for (const QPoint& q : ap.first) {
-                norm.append(QPoint(q.x() / Constants::PIXEL_SIZE, q.y() / Constants::PIXEL_SIZE));
-            }
-            fillPolygon(p, norm, ap.second);
+    m_exactCarSprites.resize(m_exactCar ? m_frame.bodies.size() : 0);
+    for (int i = 0; i < m_frame.bodies.size(); ++i) {
+        const RenderSnapshot::BodyPose& pose = m_frame.bodies[i];
+        const double x = pose.x - m_cameraX;
+        const double y = pose.y + m_cameraY;
+        const double angle = pose.angle;
+        const int gx = int(std::floor(x / Constants::PIXEL_SIZE));
+        const int gy = int(std::floor(y / Constants::PIXEL_SIZE));
+        if (m_exactCar) {
+            m_exactCarSprites[i] = rasterizeCar(pose.shape, x, y, angle);
+            m_vehicleSprites.push_back({&m_exactCarSprites[i], gx, gy});
+            continue;
         }
+        const long turn = std::lround(angle * (CAR_ANGLES / (2.0 * M_PI)));
+        const int angleIndex = int(((turn % CAR_ANGLES) + CAR_ANGLES) % CAR_ANGLES);
+        m_vehicleSprites.push_back({&carSprite(pose.shape, angleIndex), gx, gy});
     }
-    m_flip.drawWorldPopups(p, m_cameraX, m_cameraY, level_index);
-
-    p.restore();
-
-    drawHUDFuel(p);
-    drawHUDCoins(p);
-    m_nitroSys.drawHUD(p, m_elapsedSeconds, level_index);
-    m_flip.drawHUD(p, level_index);
-    drawHUDDistance(p);
-    drawHUDScore(p);
-    m_keylog.draw(p, width(), height(), Constants::PIXEL_SIZE);
 }
 
-void MainWindow::updateCamera(double tx, double ty, double dt) {
-    const double wn = m_camWN;
-    const double z  = m_camZeta;
-    const double ax = wn*wn * (tx - m_camX) - 2.0*z*wn * m_camVX;
-    m_camVX += ax * dt;
-    m_camX  += m_camVX * dt;
-    const double ay = wn*wn * (ty - m_camY) - 2.0*z*wn * m_camVY;
-    m_camVY += ay * dt;
-    m_camY  += m_camVY * dt;
+void MainWindow::renderBand(GridCanvas& g) const {
+    g.clear(Constants::SKY_COLOR[level_index].rgb());
+
+    drawStars(g);
+    drawClouds(g);
+    drawFilledTerrain(g);
+    m_propSys.draw(g, m_terrain);
+    ItemRenderer::draw(g, m_frame.items, m_cameraX, m_cameraY);
+    drawNitroFlame(g);
+    for (const PlacedSprite& s : m_vehicleSprites) g.blit(s.gx, s.gy, *s.sprite);
+    drawFlipPopups(g);
 }
 
 void MainWindow::drawGridOverlay(QPainter& p) {
@@ -420,8 +336,8 @@ void MainWindow::drawGridOverlay(QPainter& p) {
     pen.setWidth(1);
     p.setPen(pen);
     p.setBrush(Qt::NoBrush);
-    for (int x = 0; x <= width(); x += Constants::PIXEL_SIZE) p.drawLine(x, 0, x, height());
-    for (int y = 0; y <= height(); y += Constants::PIXEL_SIZE) p.drawLine(0, y, width(), y);
+    for (int x = 0; x <= viewW(); x += Constants::PIXEL_SIZE) p.drawLine(x, 0, x, viewH());
+    for (int y = 0; y <= viewH(); y += Constants::PIXEL_SIZE) p.drawLine(0, y, viewW(), y);
     p.restore();
 }
 
@@ -430,107 +346,52 @@ void MainWindow::plotGridPixel(QPainter& p, int gx, int gy, const QColor& c) {
     p.fillRect(gx * Constants::PIXEL_SIZE, gy * Constants::PIXEL_SIZE, Constants::PIXEL_SIZE, Constants::PIXEL_SIZE, c);
 }
 
-void MainWindow::drawCircleFilledMidpointGrid(QPainter& p, int gcx, int gcy, int gr, const QColor& c)
+const GridSprite& MainWindow::wheelSprite(int gr, int innerR)
 {
-    int x = 0;
-    int y = gr;
-    int d = 1 - gr;
-    auto span = [&](int cy, int xl, int xr) { for (int xg = xl; xg <= xr; ++xg) plotGridPixel(p, xg, cy, c); };
-    while (y >= x) {
-        span(gcy + y, gcx - x, gcx + x);
-        span(gcy - y, gcx - x, gcx + x);
-        span(gcy + x, gcx - y, gcx + y);
-        span(gcy - x, gcx - y, gcx + y);
-        ++x;
-        if (d < 0) d += 2 * x + 1;
-        else { --y; d += 2 * (x - y) + 1; }
-    }
+    const quint64 key = SpriteCache::key({gr, innerR});
+    if (const GridSprite* s = m_wheelSprites.find(key)) return *s;
+
+    GridCanvas c;
+    c.resize(2 * gr + 1, 2 * gr + 1);
+    c.clearTransparent();
+    c.fillDisc(gr, gr, gr, Constants::WHEEL_COLOR_OUTER.rgb());
+    c.fillDisc(gr, gr, innerR, Constants::WHEEL_COLOR_INNER.rgb());
+    return m_wheelSprites.insert(key, c.takeSprite(gr, gr));
 }
 
-void MainWindow::fillPolygon(QPainter& p, QVector<QPoint> points, const QColor& c)
+void MainWindow::drawCar(GridCanvas& g, const CarShape& body, double x, double y, double angle)
 {
-    if (points.size() < 3) return;
-
-    struct EdgeEntry { int y_max; double x_at_min; double inv_slope; EdgeEntry(int ymax, double x_min, double inv_s) : y_max(ymax), x_at_min(x_min), inv_slope(inv_s) {} };
-    struct ActiveEdge { int y_max; double x_curr; double inv_slope; ActiveEdge(const EdgeEntry& e) : y_max(e.y_max), x_curr(e.x_at_min), inv_slope(e.inv_slope) {} bool operator<(const ActiveEdge& other) const { return x_curr < other.x_curr; } };
-
-    std::map<int, std::list<EdgeEntry>> edgeTable;
-    int global_y_min = std::numeric_limits<int>::max();
-    int global_y_max = std::numeric_limits<int>::min();
-
-    for (int i = 0; i < points.size(); ++i) {
-        const QPoint& p1 = points[i];
-        const QPoint& p2 = points[(i + 1) % points.size()];
-
-        global_y_min = std::min({global_y_min, p1.y(), p2.y()});
-        global_y_max = std::max({global_y_max, p1.y(), p2.y()});
-
-        const QPoint *v1 = &p1, *v2 = &p2;
-        if (v1->y() > v2->y()) std::swap(v1, v2);
-        if (v1->y() == v2->y()) continue;
-
-        double invSlope = static_cast<double>(v2->x() - v1->x()) / (v2->y() - v1->y());
-        edgeTable[v1->y()].emplace_back(v2->y(), v1->x(), invSlope);
-    }
-
-    std::list<ActiveEdge> activeEdgeTable;
-
-    for (int y = global_y_min; y < global_y_max; ++y) {
-        if (edgeTable.count(y)) for (const auto& edge : edgeTable[y]) activeEdgeTable.emplace_back(edge);
-        activeEdgeTable.remove_if([y](const ActiveEdge& e){ return e.y_max == y; });
-        activeEdgeTable.sort();
-
-        for (auto it = activeEdgeTable.begin(); it != activeEdgeTable.end(); it++) {
-            auto it_next = std::next(it);
-            if (it_next == activeEdgeTable.end()) break;
-            int x_start = static_cast<int>(std::ceil(it->x_curr));
-            int x_end = static_cast<int>(std::floor(it_next->x_curr));
-            for (int xg = x_start; xg <= x_end; ++xg) plotGridPixel(p, xg, y, c);
-            ++it;
-        }
-
-        for (auto& edge : activeEdgeTable) edge.x_curr += edge.inv_slope;
+    for (int i = -1; i < body.attachmentCount(); ++i) {
+        body.posed(i, x, y, angle, m_carPolygon);
+        for (QPoint& q : m_carPolygon) q = QPoint(q.x() / Constants::PIXEL_SIZE, q.y() / Constants::PIXEL_SIZE);
+        m_polygonFill.fill(g, m_carPolygon, (i < 0 ? Constants::CAR_COLOR : body.attachmentColor(i)).rgb());
     }
 }
 
-void MainWindow::rasterizeSegmentToHeightMapWorld(int x1,int y1,int x2,int y2){
-    if (x2 < x1) { std::swap(x1,x2); std::swap(y1,y2); }
-
-    const int gx1 = x1 / Constants::PIXEL_SIZE;
-    const int gx2 = x2 / Constants::PIXEL_SIZE;
-
-    if (x2 == x1) {
-        const int gy = static_cast<int>(std::floor(y1 / double(Constants::PIXEL_SIZE) + 0.5));
-        m_heightAtGX.insert(gx1, gy);
-        return;
-    }
-
-    const double dx = double(x2 - x1);
-    const double dy = double(y2 - y1);
-
-    for (int gx = gx1; gx <= gx2; ++gx) {
-        const double wx = gx * double(Constants::PIXEL_SIZE);
-        double t = (wx - x1) / dx;
-        t = std::clamp(t, 0.0, 1.0);
-
-        const double wy = y1 + t * dy;
-        const int gy = static_cast<int>(std::floor(wy / double(Constants::PIXEL_SIZE) + 0.5));
-
-        m_heightAtGX.insert(gx, gy);
-    }
+GridSprite MainWindow::rasterizeCar(const CarShape& body, double x, double y, double angle)
+{
+    // room for the car at any orientation around the anchor cell
+    body.posed(-1, 0, 0, 0, m_carPolygon);
+    double reach = 0;
+    for (const QPoint& q : m_carPolygon) reach = std::max(reach, std::hypot(double(q.x()), double(q.y())));
+    const int r = int(std::ceil(reach / Constants::PIXEL_SIZE)) + 1;
+
+    const double fx = x - std::floor(x / Constants::PIXEL_SIZE) * Constants::PIXEL_SIZE;
+    const double fy = y - std::floor(y / Constants::PIXEL_SIZE) * Constants::PIXEL_SIZE;
+    GridCanvas c;
+    c.resize(2 * r + 2, 2 * r + 2);
+    c.clearTransparent();
+    drawCar(c, body, r * Constants::PIXEL_SIZE + fx, r * Constants::PIXEL_SIZE + fy, angle);
+    return c.takeSprite(r, r);
 }
 
-void MainWindow::pruneHeightMap() {
-    if (m_lines.isEmpty()) return;
-
-    const int keepFromGX = (m_lines.first().getX1() / Constants::PIXEL_SIZE) - 4;
-    QList<int> toRemove;
-    toRemove.reserve(m_heightAtGX.size());
-
-    for (auto it = m_heightAtGX.constBegin(); it != m_heightAtGX.constEnd(); ++it) {
-        if (it.key() < keepFromGX) toRemove.append(it.key());
-    }
-    for (int k : toRemove) m_heightAtGX.remove(k);
+const GridSprite& MainWindow::carSprite(const CarShape& body, int angleIndex)
+{
+    if (int(m_carSprites.size()) != CAR_ANGLES) m_carSprites.resize(CAR_ANGLES);
+    GridSprite& sprite = m_carSprites[angleIndex];
+    // the centre sits on a cell corner
+    if (sprite.w == 0) sprite = rasterizeCar(body, 0, 0, angleIndex * (2.0 * M_PI / CAR_ANGLES));
+    return sprite;
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event) {
@@ -561,6 +422,10 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
             m_showGrid = !m_showGrid;
             break;
 
+        case Qt::Key_R:
+            m_exactCar = !m_exactCar;
+            break;
+
         case Qt::Key_P:
             if (!m_intro && !m_outro && m_timer && m_timer->isActive()) {
                 m_timer->stop();
@@ -617,51 +482,14 @@ void MainWindow::keyReleaseEvent(QKeyEvent *event) {
 }
 
 
-double MainWindow::averageSpeed() const {
-    if (m_wheels.isEmpty()) return 0.0;
-    double s = 0.0;
-    for (const Wheel* w : m_wheels) s += std::sqrt(w->m_vx*w->m_vx + w->m_vy*w->m_vy);
-    return s / m_wheels.size();
-}
-
-void MainWindow::ensureAheadTerrain(int worldX) {
-    while (m_lastX < worldX) {
-        m_slope += (m_dist(m_rng) - (1 - m_terrain_height/100) * static_cast<float>(m_lastY) / height()) * m_difficulty;
-        m_slope = std::clamp(m_slope, -1.0f, 1.0f);
-
-        const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), m_irregularity) * Constants::STEP);
-
-        Line seg(m_lastX, m_lastY, m_lastX + Constants::STEP, newY);
-        m_lines.append(seg);
-        rasterizeSegmentToHeightMapWorld(seg.getX1(), m_lastY, seg.getX2(), newY);
-        int currentWorldX = m_lastX;
-        
-        int gx = currentWorldX / Constants::PIXEL_SIZE;
-        int groundGy = groundGyNearestGX(gx);
-        m_propSys.maybeSpawnProp(currentWorldX, groundGy, level_index, m_slope, m_rng);
-
-        m_lastY = newY;
-        m_lastX += Constants::STEP;
-
-        if (m_lines.size() > (width() / Constants::STEP) * 3) { m_lines.removeFirst(); pruneHeightMap(); }
-
-        m_difficulty += Constants::DIFFICULTY_INCREMENT[level_index];
-        m_irregularity += Constants::IRREGULARITY_INCREMENT[level_index];
-        if(m_terrain_height < 0.5) m_terrain_height += Constants::TERRAIN_HEIGHT_INCREMENT[level_index];
-        m_fuelSys.maybePlaceFuelAtEdge(m_lastX, m_heightAtGX, m_difficulty, m_elapsedSeconds);
-        maybeSpawnCloud();
-    }
-}
-
-void MainWindow::maybeSpawnCloud() {
-    if (m_lastX - m_lastCloudSpawnX < Constants::CLOUD_SPACING_PX) return;
+void MainWindow::maybeSpawnCloud(int worldX) {
+    if (worldX - m_lastCloudSpawnX < Constants::CLOUD_SPACING_PX) return;
     if (m_dist(m_rng) > Constants::CLOUD_PROBABILITY[level_index]) return;
 
-    int gx = m_lastX / Constants::PIXEL_SIZE;
-    auto it = m_heightAtGX.constFind(gx);
-    if (it == m_heightAtGX.constEnd()) return;
+    int gx = worldX / Constants::PIXEL_SIZE;
+    if (!m_terrain.hasHeight(gx)) return;
 
-    int gyGround = it.value();
+    int gyGround = m_terrain.heightAt(gx);
 
     std::uniform_int_distribution<int> wdist(Constants::CLOUD_MIN_W_CELLS, Constants::CLOUD_MAX_W_CELLS);
     std::uniform_int_distribution<int> hdist(Constants::CLOUD_MIN_H_CELLS, Constants::CLOUD_MAX_H_CELLS);
@@ -673,161 +501,268 @@ void MainWindow::maybeSpawnCloud() {
     int cloudTopCells = gyGround - skyLift;
 
     Cloud cl;
-    cl.wx = m_lastX;
+    cl.wx = worldX;
     cl.wyCells = cloudTopCells;
     cl.wCells  = wCells;
     cl.hCells  = hCells;
     cl.seed = m_rng();
 
-    m_clouds.append(cl);
-    m_lastCloudSpawnX = m_lastX;
+    const QColor cMain = Constants::CLOUD_COLOR[level_index];
+    const QRgb main = cMain.rgb();
+    const QRgb soft = qRgb(cMain.red()*0.9, cMain.green()*0.9, cMain.blue()*0.9);
+    // dropped clouds hand back their texels; a fresh buffer has room for the largest cloud
+    if (!m_spareCloudTexels.empty()) {
+        cl.sprite.texels = std::move(m_spareCloudTexels.back());
+        m_spareCloudTexels.pop_back();
+    } else {
+        cl.sprite.texels.reserve(size_t(Constants::CLOUD_MAX_W_CELLS) * Constants::CLOUD_MAX_H_CELLS);
+    }
+    cl.sprite.reset(wCells, hCells);
+    for (int yy = 0; yy < hCells; ++yy) {
+        for (int xx = 0; xx < wCells; ++xx) {
+            double nx = ((xx + 0.5) - wCells / 2.0) / (wCells / 2.0);
+            double ny = ((yy + 0.5) - hCells / 2.0) / (hCells / 2.0);
+            double r2 = nx*nx + ny*ny;
+
+            quint32 h = hash2D(int(cl.seed) + xx, yy);
+            double fuzz = (h % 100) / 400.0;
+
+            if (r2 <= 1.0 + fuzz) cl.sprite.set(xx, yy, ((h >> 3) & 1) ? main : soft);
+        }
+    }
 
-    int leftLimit = leftmostTerrainX() - width()*2;
+    m_clouds.append(std::move(cl));
+    m_lastCloudSpawnX = worldX;
+
+    int leftLimit = m_terrain.front().getX1() - viewW()*2;
     for (int i = 0; i < m_clouds.size(); ) {
-        if (m_clouds[i].wx < leftLimit) m_clouds.removeAt(i);
-        else ++i;
+        if (m_clouds[i].wx < leftLimit) {
+            m_spareCloudTexels.push_back(std::move(m_clouds[i].sprite.texels));
+            m_clouds.removeAt(i);
+        } else {
+            ++i;
+        }
     }
 }
 
-void MainWindow::drawClouds(QPainter& p) {
+void MainWindow::drawClouds(GridCanvas& g) const {
     if (Constants::CLOUD_PROBABILITY[level_index] <= 0.001) return;
 
     int camGX = m_cameraX / Constants::PIXEL_SIZE;
     int camGY = m_cameraY / Constants::PIXEL_SIZE;
 
-    auto plotGridPixelLocal = [&](int gx, int gy, const QColor& c) {
-        p.fillRect(gx * Constants::PIXEL_SIZE, gy * Constants::PIXEL_SIZE, Constants::PIXEL_SIZE, Constants::PIXEL_SIZE, c);
-    };
-
     for (const Cloud& cl : m_clouds) {
         int baseGX = (cl.wx / Constants::PIXEL_SIZE) - camGX;
         int baseGY = cl.wyCells + camGY;
+        if (baseGX >= g.width() || baseGX + cl.wCells <= 0) continue;
+        g.blit(baseGX, baseGY, cl.sprite);
+    }
+}
 
-        for (int yy = 0; yy < cl.hCells; ++yy) {
-            for (int xx = 0; xx < cl.wCells; ++xx) {
-                double nx = ((xx + 0.5) - cl.wCells  / 2.0) / (cl.wCells  / 2.0);
-                double ny = ((yy + 0.5) - cl.hCells / 2.0) / (cl.hCells / 2.0);
-                double r2 = nx*nx + ny*ny;
-
-                quint32 h = hash2D(int(cl.seed) + xx, yy);
-                double fuzz = (h % 100) / 400.0;
-
-                if (r2 <= 1.0 + fuzz) {
-                    QColor cMain = Constants::CLOUD_COLOR[level_index];
-                    QColor cSoft(cMain.red()*0.9,cMain.green()*0.9,cMain.blue()*0.9);
-                    QColor pix = ((h >> 3) & 1) ? cMain : cSoft;
-                    plotGridPixelLocal(baseGX + xx, baseGY + yy, pix);
-                }
-            }
-        }
+MainWindow::StarBlock& MainWindow::starBlock(int bx, int by) {
+    const int col = ((bx % m_starCols) + m_starCols) % m_starCols;
+    const int row = ((by % m_starRows) + m_starRows) % m_starRows;
+    StarBlock& s = m_starBlocks[size_t(row) * m_starCols + col];
+    if (s.bx == bx && s.by == by) return s;
+
+    s = StarBlock();
+    s.bx = bx;
+    s.by = by;
+    quint32 h = hash2D(bx, by);
+    std::mt19937 rng(h);
+    std::uniform_real_distribution<float> fdist(0.0f, 1.0f);
+
+    if (fdist(rng) < Constants::STAR_PROBABILITY[level_index] * 0.4) {
+        std::uniform_int_distribution<int> idist(0, STAR_BLOCK - 1);
+        s.lit = true;
+        s.wgx = bx * STAR_BLOCK + idist(rng);
+        s.wgy = by * STAR_BLOCK + idist(rng);
+        int alpha = std::uniform_int_distribution<int>(100, 255)(rng);
+        s.color = qRgba(255, 255, 255, alpha);
     }
+    return s;
 }
 
-void MainWindow::drawStars(QPainter& p) {
+void MainWindow::prepareStars() {
+    m_visibleStars.clear();
     if (Constants::STAR_PROBABILITY[level_index] <= 0.001) return;
 
-    const int BLOCK = 20;
     const int camGX = m_cameraX / Constants::PIXEL_SIZE;
     const int camGY = m_cameraY / Constants::PIXEL_SIZE;
 
-    const int startBX = (camGX) / BLOCK - 1;
-    const int endBX   = (camGX + gridW()) / BLOCK + 1;
-    const int startBY = (-camGY) / BLOCK - 1;
-    const int endBY   = (-camGY + gridH()) / BLOCK + 1;
+    const int startBX = (camGX) / STAR_BLOCK - 1;
+    const int endBX   = (camGX + gridW()) / STAR_BLOCK + 1;
+    const int startBY = (-camGY) / STAR_BLOCK - 1;
+    const int endBY   = (-camGY + gridH()) / STAR_BLOCK + 1;
 
     for (int bx = startBX; bx <= endBX; ++bx) {
         for (int by = startBY; by <= endBY; ++by) {
-            quint32 h = hash2D(bx, by);
-            std::mt19937 rng(h);
-            std::uniform_real_distribution<float> fdist(0.0f, 1.0f);
-
-            if (fdist(rng) < Constants::STAR_PROBABILITY[level_index] * 0.4) {
-                std::uniform_int_distribution<int> idist(0, BLOCK - 1);
-                int wgx = bx * BLOCK + idist(rng);
-                int wgy = by * BLOCK + idist(rng);
-
-                int groundGy = groundGyNearestGX(wgx);
-                if (groundGy == 0 && !m_heightAtGX.contains(wgx)) groundGy = 10000;
-
-                if (wgy < groundGy - 8) {
-                    int sgx = wgx - camGX;
-                    int sgy = wgy + camGY;
-                    int alpha = std::uniform_int_distribution<int>(100, 255)(rng);
-                    plotGridPixel(p, sgx, sgy, QColor(255, 255, 255, alpha));
-                }
+            StarBlock& s = starBlock(bx, by);
+            if (!s.lit) continue;
+
+            bool above;
+            if (s.aboveGround >= 0) {
+                above = s.aboveGround;
+            } else {
+                int groundGy = m_terrain.nearestHeight(s.wgx);
+                if (groundGy == 0 && !m_terrain.hasHeight(s.wgx)) groundGy = 10000;
+                above = s.wgy < groundGy - 8;
+                // the answer is final once the column under the star has been generated
+                if (m_terrain.hasHeight(s.wgx)) s.aboveGround = above;
             }
+            if (above) m_visibleStars.append({s.wgx - camGX, s.wgy + camGY, s.color});
         }
     }
 }
 
-void MainWindow::drawFilledTerrain(QPainter& p) {
-    const int camGX = m_cameraX / Constants::PIXEL_SIZE;
-    const int camGY = m_cameraY / Constants::PIXEL_SIZE;
+void MainWindow::drawStars(GridCanvas& g) const {
+    for (const VisibleStar& s : m_visibleStars) g.blend(s.gx, s.gy, s.color);
+}
 
-    for (int sgx = 0; sgx <= gridW(); ++sgx) {
-        const int worldGX = sgx + camGX;
-        auto it = m_heightAtGX.constFind(worldGX);
-        if (it == m_heightAtGX.constEnd()) continue;
-
-        const int groundWorldGY = it.value();
-        int startScreenGY = groundWorldGY + camGY;
-        if (startScreenGY < 0) startScreenGY = 0;
-        if (startScreenGY >= gridH()) continue;
-
-        for (int sGY = startScreenGY; sGY <= gridH(); ++sGY) {
-            const int worldGY = sGY - camGY;
-            int depth = sGY - startScreenGY; // 0 is the top surface
-
-            // === HIGHWAY LOGIC (Level 5) ===
-            if (level_index == 5) {
-                QColor c;
-                // The road is the top 14 pixels of the terrain
-                if (depth < 14) {
-                    // 1. Top Edge Highlight (Lighter gray)
-                    if (depth == 0) {
-                        c = QColor(80, 80, 85);
-                    }
-                    // 2. Yellow Dashed Line (Middle of road)
-                    // Depth 6-7 is the vertical position.
-                    // (worldGX % 20 < 10) creates the horizontal dash pattern.
-                    else if (depth >= 6 && depth <= 7 && (worldGX % 20 < 10)) {
-                        c = QColor(240, 190, 40); // Highway Yellow
-                    }
-                    // 3. Asphalt Body (Dark Gray)
-                    else {
-                        c = QColor(50, 50, 55);
-                    }
-                    plotGridPixel(p, sgx, sGY, c);
-                    continue; // Skip standard palette logic
-                }
-            }
-            // ===============================
+void MainWindow::drawFilledTerrain(GridCanvas& g) const {
+    m_terrainTiles.draw(g, m_cameraX / Constants::PIXEL_SIZE, m_cameraY / Constants::PIXEL_SIZE);
+}
 
-            bool topZone = (sGY < groundWorldGY + camGY + 3*Constants::SHADING_BLOCK);
-            const QColor shade = grassShadeForBlock(worldGX, worldGY, topZone);
-            plotGridPixel(p, sgx, sGY, shade);
+void MainWindow::drawNitroFlame(GridCanvas& p) const {
+    const NitroSystem& nitro = m_frame.nitroSys;
+    const QVector<WheelPose>& wheels = m_frame.wheels;
+    if (!nitro.active) return;
+    if (wheels.size() < 2) return;
+
+    const WheelPose& back  = wheels.first();
+    const WheelPose& front = wheels[1];
+
+    auto info = back.get(0, 0, viewW(), viewH(), -m_cameraX, m_cameraY);
+    if (!info) return;
+
+    const int cx = (*info)[0];
+    const int cy = (*info)[1];
+    const int r  = (*info)[2];
+    if (r <= 0) return;
+
+    const int gcx = cx / Constants::PIXEL_SIZE;
+    const int gcy = cy / Constants::PIXEL_SIZE;
+    const int gr  = std::max(1, r / Constants::PIXEL_SIZE);
+
+    double ux = front.x - back.x;
+    double uy = front.y - back.y;
+    double L = std::sqrt(ux*ux + uy*uy);
+    if (L < 1e-6) return;
+    ux /= L; uy /= L;
+
+    const int nozzleOff = gr + 2;
+    int nozzleGX = gcx - int(std::round(ux * nozzleOff));
+    int nozzleGY = gcy - int(std::round(uy * nozzleOff));
+
+    const double upx = uy;
+    const double upy = -ux;
+    const int liftCells = std::max(1, gr/2);
+    nozzleGX += int(std::round(upx * liftCells));
+    nozzleGY += int(std::round(upy * liftCells));
+
+    QColor cNoz (70, 70, 80);
+    QColor cOuter(255, 100, 35);
+    QColor cMid  (255, 160, 45);
+    QColor cCore (255, 240, 120);
+
+    auto plot = [&](int gx, int gy, const QColor& c){
+        p.plot(gx, gy, c);
+    };
+
+    plot(nozzleGX, nozzleGY, cNoz);
+
+    const int lenCells   = 5;
+    const int baseWidth  = 1;
+
+    const double nx = -uy;
+    const double ny =  ux;
+
+    for (int i = 1; i <= lenCells; ++i) {
+        const int cxg = nozzleGX - int(std::round(ux * i));
+        const int cyg = nozzleGY - int(std::round(uy * i));
+
+        const double t = double(i) / double(lenCells);
+        const int wOuter = std::max(0, int(std::lround(baseWidth * (1.0 - t))));
+        const int wMid   = std::max(0, wOuter - 1);
+        const int wCore  = std::max(0, int(std::floor(wOuter * 0.5)));
+
+        for (int j = -wOuter; j <= wOuter; ++j) {
+            const int gx = cxg + int(std::round(nx * j));
+            const int gy = cyg + int(std::round(ny * j));
+            plot(gx, gy, cOuter);
         }
+        for (int j = -wMid; j <= wMid; ++j) {
+            const int gx = cxg + int(std::round(nx * j));
+            const int gy = cyg + int(std::round(ny * j));
+            plot(gx, gy, cMid);
+        }
+        for (int j = -wCore; j <= wCore; ++j) {
+            const int gx = cxg + int(std::round(nx * j));
+            const int gy = cyg + int(std::round(ny * j));
+            plot(gx, gy, cCore);
+        }
+    }
+}
 
-        // Draw the top edge pixel (only for non-highway levels)
-        if (level_index != 5) {
-            const QColor edge = grassShadeForBlock(worldGX, groundWorldGY, true).darker(115);
-            plotGridPixel(p, sgx, groundWorldGY + camGY, edge);
+namespace {
+void drawPixelWordFlip(GridCanvas& p, int gx, int gy, const QColor& c)
+{
+    const QRgb rgb = c.rgb();
+    auto plot=[&](int x,int y){ p.plot(gx+x, gy+y, rgb); };
+    static const uint8_t F[7]={0x1F,0x10,0x1E,0x10,0x10,0x10,0x10};
+    static const uint8_t l[7]={0x04,0x04,0x04,0x04,0x04,0x04,0x06};
+    static const uint8_t i[7]={0x00,0x08,0x00,0x18,0x08,0x08,0x1C};
+    static const uint8_t glyphP[7]={0x00,0x00,0x1C,0x12,0x1C,0x10,0x10};
+    static const uint8_t ex[7]={0x04,0x04,0x04,0x04,0x04,0x00,0x04};
+
+    auto drawChar=[&](const uint8_t rows[7], int ox){
+        for(int ry=0; ry<7; ++ry){
+            uint8_t row=rows[ry];
+            for(int rx=0; rx<5; ++rx)
+                if (row & (1<<(4-rx))) plot(ox+rx, ry);
         }
+    };
+
+    int adv=6;
+    drawChar(F, 0);
+    drawChar(l, adv*1);
+    drawChar(i, adv*2);
+    drawChar(glyphP, adv*3);
+    drawChar(ex,adv*4);
+}
+}
+
+void MainWindow::drawFlipPopups(GridCanvas& p) const
+{
+    const int screenPadCells = 10;
+
+    for (int i = 0; i < m_frame.flip.popupCount(); ++i) {
+        const FlipTracker::Popup& pop = m_frame.flip.popup(i);
+        const int gx = (pop.wx - m_cameraX) / Constants::PIXEL_SIZE + screenPadCells;
+        const int gy = (pop.wy + m_cameraY) / Constants::PIXEL_SIZE;
+        drawPixelWordFlip(p, gx, gy, Constants::FLIP_COLOR[level_index]);
     }
 }
 
-QColor MainWindow::grassShadeForBlock(int worldGX, int worldGY, bool greenify) const {
-    const int bx = worldGX / Constants::SHADING_BLOCK;
-    const int by = worldGY / Constants::SHADING_BLOCK;
-    const quint32 h = hash2D(bx, by);
+void MainWindow::shadeTerrainColumn(QRgb* out, int worldGX, int worldGY, int n, int groundGY) const {
+    TerrainShade::shadeColumn(out, worldGX, worldGY, n, groundGY, level_index);
+}
 
-    if (greenify) {
-        const int idxG = int(h % m_grassPalette.size());
-        return m_grassPalette[level_index][idxG];
-    } else {
-        const int idxD = int(h % m_dirtPalette.size());
-        return m_dirtPalette[level_index][idxD];
+void MainWindow::shadeHighwayColumn(QRgb* out, int worldGX, int worldGY, int n, int groundGY) const {
+    // The road is the top 14 pixels of the terrain
+    int i = 0;
+    for (; i < n && worldGY + i - groundGY < 14; ++i) {
+        const int depth = worldGY + i - groundGY; // 0 is the top surface
+        // 1. Top Edge Highlight (Lighter gray)
+        if (depth == 0) out[i] = qRgb(80, 80, 85);
+        // 2. Yellow Dashed Line (Middle of road)
+        // Depth 6-7 is the vertical position.
+        // (worldGX % 20 < 10) creates the horizontal dash pattern.
+        else if (depth >= 6 && depth <= 7 && (worldGX % 20 < 10)) out[i] = qRgb(240, 190, 40); // Highway Yellow
+        // 3. Asphalt Body (Dark Gray)
+        else out[i] = qRgb(50, 50, 55);
     }
+    TerrainShade::shadeColumn(out + i, worldGX, worldGY + i, n - i, groundGY, level_index);
 }
 
 void MainWindow::drawHUDFuel(QPainter& p) {
@@ -836,7 +771,7 @@ void MainWindow::drawHUDFuel(QPainter& p) {
     int gx = (gridW() - wcells)/2;
     int barH = 3;
 
-    double frac = std::clamp(m_fuel / Constants::FUEL_MAX, 0.0, 1.0);
+    double frac = std::clamp(m_frame.fuel / Constants::FUEL_MAX, 0.0, 1.0);
     int filled = int(std::floor(wcells * frac));
 
     auto lerp = [](const QColor& c1, const QColor& c2, double t)->QColor {
@@ -875,8 +810,8 @@ void MainWindow::drawHUDFuel(QPainter& p) {
         plotGridPixel(p, gx+x, gy+barH, QColor(80,80,70));
     const double lowFuelThreshold = Constants::FUEL_MAX * 0.25;
     
-    const bool isLow = (m_fuel <= lowFuelThreshold);
-    const bool isFlashingOn = (std::fmod(m_elapsedSeconds, 1.0) < 0.5);
+    const bool isLow = (m_frame.fuel <= lowFuelThreshold);
+    const bool isFlashingOn = (std::fmod(m_frame.elapsedSeconds, 1.0) < 0.5);
     
     if (isLow && isFlashingOn) {
         const QColor red(230, 50, 40);
@@ -932,67 +867,97 @@ void MainWindow::drawHUDFuel(QPainter& p) {
 }
 
 void MainWindow::drawHUDCoins(QPainter& p) {
-    int iconGX = Constants::HUD_LEFT_MARGIN + Constants::COIN_RADIUS_CELLS + 1;
-    int iconGY = Constants::HUD_TOP_MARGIN  + Constants::COIN_RADIUS_CELLS;
-    drawCircleFilledMidpointGrid(p, iconGX, iconGY, Constants::COIN_RADIUS_CELLS, QColor(195,140,40));
-    drawCircleFilledMidpointGrid(p, iconGX, iconGY, std::max(1, Constants::COIN_RADIUS_CELLS-1), QColor(250,204,77));
-    plotGridPixel(p, iconGX-1, iconGY-Constants::COIN_RADIUS_CELLS+1, QColor(255,255,220));
-    QFont f; f.setFamily("Monospace"); f.setBold(true); f.setPointSize(12);
-    p.setFont(f);
+    const int r = Constants::COIN_RADIUS_CELLS;
+    if (m_hudCoinIcon.isNull()) {
+        GridCanvas c;
+        c.resize(2 * r + 1, 2 * r + 1);
+        c.clearTransparent();
+        c.fillDisc(r, r, r, qRgb(195,140,40));
+        c.fillDisc(r, r, std::max(1, r-1), qRgb(250,204,77));
+        c.plot(r-1, 1, QColor(255,255,220));
+        m_hudCoinIcon = c.takeSprite(r, r).image();
+    }
+    const int iconGX = Constants::HUD_LEFT_MARGIN + 1;
+    const int iconGY = Constants::HUD_TOP_MARGIN;
+    p.drawImage(QRect(iconGX * Constants::PIXEL_SIZE, iconGY * Constants::PIXEL_SIZE,
+                      m_hudCoinIcon.width() * Constants::PIXEL_SIZE, m_hudCoinIcon.height() * Constants::PIXEL_SIZE),
+                m_hudCoinIcon);
+    p.setFont(m_hudFont);
     p.setPen(Constants::TEXT_COLOR[level_index]);
     int px = (Constants::HUD_LEFT_MARGIN + Constants::COIN_RADIUS_CELLS*2 + 3) * Constants::PIXEL_SIZE;
     int py = (Constants::HUD_TOP_MARGIN  + Constants::COIN_RADIUS_CELLS + 2) * Constants::PIXEL_SIZE;
-    p.drawText(px, py, QString::number(m_coinCount));
+    formatInto(m_hudText, "%d", m_frame.coinCount);
+    p.drawText(px, py, m_hudText);
+}
+
+void MainWindow::drawHUDNitro(QPainter& p) {
+    const NitroSystem& nitro = m_frame.nitroSys;
+    const double elapsedSeconds = m_frame.elapsedSeconds;
+    int baseGX = Constants::HUD_LEFT_MARGIN;
+    int baseGY = Constants::HUD_TOP_MARGIN + Constants::COIN_RADIUS_CELLS*2 + 4;
+    QColor hull(90,90,110);
+    QColor tip(180,180,190);
+    QColor windowC(120,200,230);
+    QColor flame1(255,180,60);
+    QColor flame2(255,110,40);
+    QColor shadow(20,14,24);
+    auto plot = [&](int gx, int gy, const QColor& c){
+        p.fillRect((baseGX+gx) * Constants::PIXEL_SIZE,
+                   (baseGY+gy) * Constants::PIXEL_SIZE,
+                   Constants::PIXEL_SIZE, Constants::PIXEL_SIZE, c);
+    };
+    plot(1,1,hull); plot(2,1,hull); plot(3,1,hull); plot(4,1,hull);
+    plot(1,2,hull); plot(2,2,windowC); plot(3,2,hull); plot(4,2,hull); plot(5,2,tip);
+    plot(1,3,hull); plot(2,3,hull); plot(3,3,hull); plot(4,3,hull);
+    plot(0,2,flame1); plot(0,3,flame2);
+    plot(2,4,shadow);
+    p.setFont(m_hudFont);
+    p.setPen(Constants::TEXT_COLOR[level_index]);
+    double tleft = 0.0;
+    if (nitro.active) tleft = std::max(0.0, nitro.endTime - elapsedSeconds);
+    else if (elapsedSeconds < nitro.cooldownUntil) tleft = std::max(0.0, nitro.cooldownUntil - elapsedSeconds);
+    int pxText = (baseGX + 8) * Constants::PIXEL_SIZE;
+    int pyText = (baseGY + 5) * Constants::PIXEL_SIZE;
+    formatInto(m_hudText, "%d", int(std::ceil(tleft)));
+    p.drawText(pxText, pyText, m_hudText);
+}
+
+void MainWindow::drawHUDFlips(QPainter& p) {
+    const int textGX = Constants::HUD_LEFT_MARGIN + 1;
+    const int nitroBaselineGY = Constants::HUD_TOP_MARGIN + Constants::COIN_RADIUS_CELLS*2 + 4;
+    const int extraGapCells = 10;
+    const int textGY = nitroBaselineGY + 7 + extraGapCells;
+    p.setFont(m_hudFont);
+    p.setPen(Constants::TEXT_COLOR[level_index]);
+    formatInto(m_hudText, "Flips: %d", m_frame.flip.total());
+    p.drawText(textGX * Constants::PIXEL_SIZE,
+               textGY  * Constants::PIXEL_SIZE,
+               m_hudText);
 }
 
 void MainWindow::drawHUDDistance(QPainter& p) {
-    double meters = (m_totalDistanceCells * Constants::PIXEL_SIZE) / 100.0;
-    QString s = QString::number(meters, 'f', 1) + " m";
-    QFont f; f.setFamily("Monospace"); f.setBold(true); f.setPointSize(12);
-    p.setFont(f);
+    double meters = m_frame.distanceMeters;
+    formatInto(m_hudText, "%.1f m", meters);
+    p.setFont(m_hudFont);
     p.setPen(Constants::TEXT_COLOR[level_index]);
-    QFontMetrics fm(f);
-    int px = width() - fm.horizontalAdvance(s) - 12;
+    int px = viewW() - m_hudMetrics.horizontalAdvance(m_hudText) - 12;
     int py = (Constants::HUD_TOP_MARGIN + Constants::COIN_RADIUS_CELLS + 2) * Constants::PIXEL_SIZE;
-    p.drawText(px, py, s);
+    p.drawText(px, py, m_hudText);
 }
 
 
 void MainWindow::drawHUDScore(QPainter& p) {
-    const QString s = QString::number(m_score);
-    QFont f; f.setFamily("Monospace"); f.setBold(true); f.setPointSize(12);
-    p.setFont(f);
+    formatInto(m_hudText, "%d", m_frame.score);
+    p.setFont(m_hudFont);
     p.setPen(Constants::TEXT_COLOR[level_index]);
-    QFontMetrics fm(f);
     const int rightPadPx = 12;
-    const int px = width() - fm.horizontalAdvance(s) - rightPadPx;
+    const int px = viewW() - m_hudMetrics.horizontalAdvance(m_hudText) - rightPadPx;
     const int distancePy = (Constants::HUD_TOP_MARGIN + Constants::COIN_RADIUS_CELLS + 2) * Constants::PIXEL_SIZE;
     const int gapPx = 8;
-    const int py = distancePy - fm.height() - gapPx;
-    p.drawText(px, py, s);
-}
-
-
-int MainWindow::groundGyNearestGX(int gx) const {
-    auto it = m_heightAtGX.constFind(gx);
-    if (it != m_heightAtGX.constEnd()) return it.value();
-
-    for (int d = 1; d <= 8; ++d) {
-        auto itL = m_heightAtGX.constFind(gx - d);
-        if (itL != m_heightAtGX.constEnd()) return itL.value();
-        auto itR = m_heightAtGX.constFind(gx + d);
-        if (itR != m_heightAtGX.constEnd()) return itR.value();
-    }
-    return 0;
+    const int py = distancePy - m_hudMetrics.height() - gapPx;
+    p.drawText(px, py, m_hudText);
 }
 
-double MainWindow::terrainTangentAngleAtX(double wx) const {
-    int gx = int(wx / Constants::PIXEL_SIZE);
-    int gyL = groundGyNearestGX(gx - 1);
-    int gyR = groundGyNearestGX(gx + 1);
-    double dyCells = double(gyR - gyL);
-    return std::atan2(-dyCells, 2.0);
-}
 
 void MainWindow::showGameOver() {
     if (m_media) m_media->playGameOverOnce();
@@ -1001,14 +966,14 @@ void MainWindow::showGameOver() {
         if (level_index >= 0 && level_index < m_levelNames.size()) {
             stageName = m_levelNames[level_index];
         }
-        m_leaderboardMgr->submitScore(stageName, m_score);
+        m_leaderboardMgr->submitScore(stageName, m_frame.score);
     }
     if (m_outro) return;
     if (m_timer) m_timer->stop();
 
     m_outro = new OutroScreen(this);
-    m_outro->setStats(m_coinCount, m_nitroUses, m_score, (m_totalDistanceCells * Constants::PIXEL_SIZE) / 100.0);
-    m_outro->setFlips(m_flip.total());
+    m_outro->setStats(m_frame.coinCount, m_frame.nitroUses, m_frame.score, m_frame.distanceMeters);
+    m_outro->setFlips(m_frame.flip.total());
     m_outro->show();
     m_outro->raise();
 
@@ -1018,16 +983,15 @@ void MainWindow::showGameOver() {
             m_outro->deleteLater();
             m_outro = nullptr;
         }
-        m_grandTotalCoins += m_coinCount;
+        m_grandTotalCoins += m_frame.coinCount;
         saveGrandCoins();
 
         resetGameRound();
         m_pause->hide();
-        m_roofCrashLatched = false;
         m_gameOverArmed = false;
         if (m_timer) {
             m_clock.restart();
-            m_timer->start(10);
+            m_timer->start(Constants::FRAME_INTERVAL_MS);
         }
         setFocus();
     });
@@ -1039,11 +1003,10 @@ void MainWindow::returnToIntro() {
     loadGrandCoins();
     ++m_sessionId;
     m_gameOverArmed = false;
-    m_roofCrashLatched = false;
 
     if (m_timer) m_timer->stop();
 
-    m_grandTotalCoins += m_coinCount;
+    m_grandTotalCoins += m_frame.coinCount;
     saveGrandCoins();
 
     if (m_outro) {
@@ -1053,7 +1016,6 @@ void MainWindow::returnToIntro() {
     }
 
     m_accelerating = m_braking = m_nitroKey = false;
-    m_prevNitroActive = false;
 
     m_intro = new IntroScreen(this, level_index);
     m_intro->setGeometry(rect());
@@ -1086,30 +1048,6 @@ void MainWindow::returnToIntro() {
     });
 }
 
-bool MainWindow::isFullyUpsideDown() const {
-    if (m_wheels.size() < 2) return false;
-    const double dx = m_wheels[1]->x - m_wheels[0]->x;
-    const double dy = m_wheels[1]->y - m_wheels[0]->y;
-    const double len = std::hypot(dx, dy) + 1e-9;
-    const double c = dx / len;
-    const double s = dy / len;
-    return (c <= Constants::FLIPPED_COS_MIN && std::abs(s) <= Constants::FLIPPED_SIN_MAX);
-}
-
-bool MainWindow::isRoofTouchingTerrain() const {
-    if (m_bodies.isEmpty()) return false;
-    const auto probes = m_bodies.front()->getKillSwitches(0, 0);
-    const double tol = 0.5 * Constants::PIXEL_SIZE;
-    int onGround = 0;
-    for (const QPoint& pt : probes) {
-        const int gx = int(std::lround(double(pt.x()) / Constants::PIXEL_SIZE));
-        const int gyGround = groundGyNearestGX(gx);
-        const double wyGround = gyGround * Constants::PIXEL_SIZE;
-        if (pt.y() >= wyGround - tol) ++onGround;
-    }
-    return onGround >= 1;
-}
-
 void MainWindow::armGameOver() {
     if (m_gameOverArmed || m_outro) return;
     m_gameOverArmed = true;
@@ -1133,52 +1071,37 @@ void MainWindow::resetGameRound() {
     setPalette(pal);
 
     m_gameOverArmed = false;
-    m_roofCrashLatched  = false;
     ++m_sessionId;
 
-    m_nitroSys = NitroSystem();
-    m_fuelSys  = FuelSystem();
-    m_coinSys  = CoinSystem();
-
-    m_fuel = Constants::FUEL_MAX;
-    m_coinCount = 0;
-    m_nitroUses = 0;
-    m_elapsedSeconds= 0.0;
-
-    m_camX = m_camY = m_camVX = m_camVY = 0.0;
-    m_cameraX = 0; m_cameraY = 200; m_cameraXFarthest = 0;
-
-    m_lines.clear();
-    m_heightAtGX.clear();
-    m_lastX = 0;
-    m_lastY = 0;
-    m_slope = 0;
-    m_difficulty = Constants::INITIAL_DIFFICULTY[level_index];
-    m_irregularity = Constants::INITIAL_IRREGULARITY[level_index];
-    m_terrain_height = Constants::INITIAL_TERRAIN_HEIGHT[level_index];
-    generateInitialTerrain();
+    m_lastFrameNs = -1;
 
+    for (Cloud& cl : m_clouds) m_spareCloudTexels.push_back(std::move(cl.sprite.texels));
     m_clouds.clear();
     m_lastCloudSpawnX = 0;
+    std::fill(m_starBlocks.begin(), m_starBlocks.end(), StarBlock());
+    m_carSprites.clear();
     m_propSys.clear();
+    if (level_index == 5) {
+        m_terrainTiles.reset([this](QRgb* out, int gx, int gy, int n, int ground){ shadeHighwayColumn(out, gx, gy, n, ground); });
+    } else {
+        m_terrainTiles.reset([this](QRgb* out, int gx, int gy, int n, int ground){ shadeTerrainColumn(out, gx, gy, n, ground); });
+    }
 
-    qDeleteAll(m_wheels); m_wheels.clear();
-    qDeleteAll(m_bodies); m_bodies.clear();
-
-    createCar();
-
-    m_totalDistanceCells = 0.0;
-    m_score = 0;
-
-    {
-        double ax = 0.0;
-        for (const Wheel* w : m_wheels) ax += w->x;
-        m_lastScoreX = m_wheels.isEmpty() ? 0.0 : ax / m_wheels.size();
+    // the round starts from a snapshot of the freshly reset simulation, so
+    // the first frame has something to draw before the worker has run
+    joinSimulation();
+    m_simOut.terrainEdits.clear();
+    m_terrain.clear();
+    m_sim.reset(level_index, m_rng());
+    m_sim.fillSnapshot(m_simOut);
+    adoptSnapshot();
+
+    // every orientation is rasterized now, so the car never rasterizes mid-round
+    if (!m_frame.bodies.isEmpty()) {
+        for (int a = 0; a < CAR_ANGLES; ++a) carSprite(m_frame.bodies.first().shape, a);
     }
 
     m_accelerating = m_braking = m_nitroKey = false;
-    m_prevNitroActive = false;
-    m_flip.reset();
 
     m_clock.restart();
 }
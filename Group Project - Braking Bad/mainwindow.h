@@ -6,25 +6,32 @@
 #include <QList>
 #include <QVector>
 #include <QTimer>
-#include <QHash>
 #include <QColor>
+#include <QFont>
+#include <QFontMetrics>
+#include <QString>
 #include <QElapsedTimer>
+#include <limits>
+#include <memory>
 #include <random>
+#include <vector>
 
 #include "media.h"
 #include "constants.h"
 #include "line.h"
-#include "wheel.h"
+#include "simulation.h"
+#include "rendersnapshot.h"
 #include "intro.h"
-#include "carBody.h"
-#include "coin.h"
-#include "fuel.h"
-#include "nitro.h"
-#include "flip.h"
 #include "keylog.h"
 #include "pause.h"
 #include "prop.h"
+#include "gridcanvas.h"
+#include "terraintiles.h"
+#include "spritecache.h"
+#include "polygonfill.h"
+#include "terrainshade.h"
 #include "scoreboard.h"
+#include "workerthread.h"
 
 class QKeyEvent;
 class QPainter;
@@ -50,55 +57,91 @@ private:
     KeyLog m_keylog;
     Media* m_media = nullptr;
     bool m_suppressFuelSfx = false;
-    void generateInitialTerrain();
-    void createCar();
+    void onSegmentAppended(const Line& segment, float slope);
     void drawGridOverlay(QPainter& p);
-    inline int gridW() const { return width()  / Constants::PIXEL_SIZE; }
-    inline int gridH() const { return height() / Constants::PIXEL_SIZE; }
+    // The logical viewport: gameplay, culling and rendering are sized by it,
+    // never by the window. paintEvent() scales the finished frame to the
+    // window, by a whole factor whenever one fits, and letterboxes the rest.
+    int m_logicalW = Constants::LOGICAL_W_CELLS;
+    int m_logicalH = Constants::LOGICAL_H_CELLS;
+    inline int gridW() const { return m_logicalW; }
+    inline int gridH() const { return m_logicalH; }
+    inline int viewW() const { return m_logicalW * Constants::PIXEL_SIZE; }
+    inline int viewH() const { return m_logicalH * Constants::PIXEL_SIZE; }
     void plotGridPixel(QPainter& p, int gx, int gy, const QColor& c);
-    void drawCircleFilledMidpointGrid(QPainter& p, int gcx, int gcy, int gr, const QColor& c);
-    void fillPolygon(QPainter& p, QVector<QPoint> points, const QColor& c);
-    void drawFilledTerrain(QPainter& p);
+    // body outline and attachments centred on screen pixel (x, y)
+    void drawCar(GridCanvas& g, const CarShape& body, double x, double y, double angle);
+    // the car centred on screen pixel (x, y), anchored on the cell holding that pixel
+    GridSprite rasterizeCar(const CarShape& body, double x, double y, double angle);
+    void drawFilledTerrain(GridCanvas& g) const;
+    // flame behind the back wheel while nitro is on
+    void drawNitroFlame(GridCanvas& g) const;
+    // the "Flip!" popups still showing
+    void drawFlipPopups(GridCanvas& g) const;
+
+    // A frame is drawn in two steps. prepareFrame() runs on the GUI thread
+    // and does everything that fills a cache; renderBand() then draws every
+    // world layer into one band of rows and only reads, so the bands are
+    // drawn concurrently: the first on the GUI thread, band i on
+    // m_bandWorkers[i - 1], which are started once and kept.
+    void prepareFrame();
+    void renderBand(GridCanvas& g) const;
+    static constexpr int MIN_BAND_ROWS = 16;
+    QVector<GridCanvas> m_bands;
+    std::vector<std::unique_ptr<WorkerThread>> m_bandWorkers;
+
+    // wheels and car bodies, resolved to sprites by prepareFrame()
+    struct PlacedSprite {
+        const GridSprite* sprite;
+        int gx, gy;
+    };
+    std::vector<PlacedSprite> m_vehicleSprites;
 
     void drawHUDFuel(QPainter& p);
     void drawHUDCoins(QPainter& p);
+    // rocket icon and the nitro countdown
+    void drawHUDNitro(QPainter& p);
+    void drawHUDFlips(QPainter& p);
     void drawHUDDistance(QPainter& p);
     void drawHUDScore(QPainter& p);
-
-    QColor grassShadeForBlock(int worldGX, int worldGY, bool greenify) const;
-    static inline quint32 hash2D(int x, int y) {
-        quint32 h = 120003212u;
-        h ^= quint32(x); h *= 16777619u;
-        h ^= quint32(y); h *= 16777619u;
-        return (h ^ x) / (h ^ y) + (x * y) - (3 * x*x + 4 * y*y);
-    }
-    void rasterizeSegmentToHeightMapWorld(int x1, int y1, int x2, int y2);
-    void pruneHeightMap();
-    void ensureAheadTerrain(int worldX);
-    void updateCamera(double targetX, double targetY, double dtSeconds);
-    int groundGyNearestGX(int gx) const;
-    double terrainTangentAngleAtX(double wx) const;
-
-    double averageSpeed() const;
+    // the HUD text font and its metrics, built once; each HUD number is
+    // formatted into m_hudText, which keeps its buffer from frame to frame
+    static QFont hudFont();
+    QFont m_hudFont = hudFont();
+    QFontMetrics m_hudMetrics{m_hudFont};
+    QString m_hudText;
+
+    // terrain tile shaders: natural ground, and the Nightlife highway
+    void shadeTerrainColumn(QRgb* out, int worldGX, int worldGY, int n, int groundGY) const;
+    void shadeHighwayColumn(QRgb* out, int worldGX, int worldGY, int n, int groundGY) const;
+    static inline quint32 hash2D(int x, int y) { return TerrainShade::hash2D(x, y); }
 
     QElapsedTimer m_clock;
-    double m_camX  = 0.0;
-    double m_camY  = 0.0;
-    double m_camVX = 0.0;
-    double m_camVY = 0.0;
-    double m_camWN   = 20.0;
-    double m_camZeta = 0.98;
+    qint64 m_lastFrameNs = -1;
+    // car outline in grid cells, reused every frame
+    QVector<QPoint> m_carPolygon;
+    // world layer, one texel per grid cell
+    GridCanvas m_canvas;
+    PolygonFill m_polygonFill;
+    TerrainTiles m_terrainTiles;
+    // wheel discs by radius, and the HUD coin icon at one texel per cell
+    SpriteCache m_wheelSprites;
+    QImage m_hudCoinIcon;
+    const GridSprite& wheelSprite(int gr, int innerR);
+    // the car pre-rasterized at CAR_ANGLES orientations, filled when a round
+    // starts; R switches to exact rasterization, e.g. for screenshots
+    static constexpr int CAR_ANGLES = 256;
+    std::vector<GridSprite> m_carSprites;
+    bool m_exactCar = false;
+    std::vector<GridSprite> m_exactCarSprites;   // this frame's, when m_exactCar
+    const GridSprite& carSprite(const CarShape& body, int angleIndex);
 
     OutroScreen* m_outro = nullptr;
-    int m_nitroUses = 0;
-    bool m_prevNitroActive = false;
     bool m_gameOverArmed = false;
     int  m_sessionId = 0;
 
     void showGameOver();
     void returnToIntro();
-    bool isFullyUpsideDown() const;
-    bool isRoofTouchingTerrain() const;
     void armGameOver();
     void disarmGameOver();
 
@@ -112,21 +155,30 @@ private:
 private:
     QTimer *m_timer = nullptr;
 
-    QList<Line>   m_lines;
-    QList<Wheel*> m_wheels;
-    QList<CarBody*> m_bodies;
-
-    int   m_lastX = 0;
-    int   m_lastY = 0;
-    float m_slope = 0.0f;
-
-    double m_difficulty;
-    double m_irregularity;
-    double m_terrain_height;
+    // The simulation runs a frame's ticks on a worker thread while the GUI
+    // thread draws the ticks before them. The worker advances m_sim by
+    // m_simFrameSeconds and fills m_simOut (its terrain hooks record into
+    // m_simOut.terrainEdits); gameLoop() waits for it and adoptSnapshot()
+    // swaps it into m_frame, which is all painting reads. Anything else
+    // touching m_sim calls joinSimulation() first.
+    Simulation m_sim;
+    bool m_simPending = false;
+    double m_simFrameSeconds = 0.0;
+    RenderSnapshot m_simOut;
+    RenderSnapshot m_frame;
+    // declared after what its task touches, so it is stopped first
+    WorkerThread m_simWorker{[this] {
+        m_sim.advance(m_simFrameSeconds);
+        m_sim.fillSnapshot(m_simOut);
+    }};
+    void joinSimulation();
+    void adoptSnapshot();
+    // the simulation's terrain, rebuilt from the adopted edits, under the
+    // props, clouds, stars and terrain tiles
+    TerrainStore m_terrain;
 
     int m_cameraX = 0;
     int m_cameraY = 200;
-    int m_cameraXFarthest = 0;
 
     bool m_accelerating = false;
     bool m_braking      = false;
@@ -137,53 +189,55 @@ private:
 
     bool m_showGrid = false;
 
-    QHash<int,int> m_heightAtGX;
-    int leftmostTerrainX() const;
-    double m_elapsedSeconds = 0.0;
-
-    FuelSystem  m_fuelSys;
-    CoinSystem  m_coinSys;
-    NitroSystem m_nitroSys;
     PropSystem m_propSys;
 
-    double m_fuel = Constants::FUEL_MAX;
-    int m_coinCount = 0;
-
     struct Cloud {
         int wx;
         int wyCells;
         int wCells;
         int hCells;
         quint32 seed;
+        GridSprite sprite;   // rasterized once at spawn
     };
 
     QVector<Cloud> m_clouds;
+    // texel buffers of dropped clouds, reused by the next ones spawned
+    std::vector<std::vector<QRgb>> m_spareCloudTexels;
     int m_lastCloudSpawnX = 0;
-    void maybeSpawnCloud();
-    void drawClouds(QPainter& p);
-
-    struct Star {
-        int wx;
-        int wyCells;
-        int alpha;
+    void maybeSpawnCloud(int worldX);
+    void drawClouds(GridCanvas& g) const;
+
+    // The star, if any, of one STAR_BLOCK x STAR_BLOCK block of sky. Generated
+    // the first time the block is seen and kept in its slot of m_starBlocks
+    // until another block wrapping onto the same slot comes into view.
+    struct StarBlock {
+        int bx = std::numeric_limits<int>::min(), by = 0;   // the block held, none yet
+        bool lit = false;
+        int wgx = 0, wgy = 0;
+        QRgb color = 0;
+        qint8 aboveGround = -1;   // -1 until the terrain under the star exists
     };
-
-    QVector<Star> m_stars;
-    int m_lastStarSpawnX = 0;
-    void drawStars(QPainter& p);
+    static constexpr int STAR_BLOCK = 20;
+
+    // blocks wrap onto a fixed grid a few blocks wider and taller than the
+    // view, so scrolling reuses slots instead of growing a table
+    std::vector<StarBlock> m_starBlocks;
+    int m_starCols = 0, m_starRows = 0;
+    StarBlock& starBlock(int bx, int by);
+    // lit, above-ground stars in view, in canvas cells
+    struct VisibleStar {
+        int gx, gy;
+        QRgb color;
+    };
+    QVector<VisibleStar> m_visibleStars;
+    void prepareStars();
+    void drawStars(GridCanvas& g) const;
 
 
     IntroScreen* m_intro = nullptr;
-    bool m_roofCrashLatched = false;
-
-    double m_lastScoreX = 0.0;
-    double m_totalDistanceCells = 0.0;
-    int m_score = 0;
 
     int m_grandTotalCoins = 0;
 
-    FlipTracker m_flip;
-
     int level_index;
     PauseOverlay* m_pause = nullptr;
 };
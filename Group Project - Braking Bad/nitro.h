@@ -1,9 +1,8 @@
 #ifndef NITRO_H
 #define NITRO_H
 
-#include <QPainter>
-#include <QColor>
 #include <QList>
+#include <QVector>
 #include <cmath>
 #include <functional>
 #include "constants.h"
@@ -28,13 +27,7 @@ public:
         );
 
     // Use the *previous* thrust direction (first two wheels) and clamp behavior
-    void applyThrust(QList<Wheel*>& wheels) const;
-
-    // Keep the *previous* pixel HUD (rocket icon + countdown)
-    void drawHUD(QPainter& p, double elapsedSeconds, int levelIndex) const;
-
-    // Keep the *previous* nitro flame look (based on first/back wheel and first front)
-    void drawFlame(QPainter& p, const QList<Wheel*>& wheels, int cameraX, int cameraY, int viewW, int viewH) const;
+    void applyThrust(QList<Wheel*>& wheels, double stepScale = 1.0) const;
 };
 
 #endif // NITRO_H
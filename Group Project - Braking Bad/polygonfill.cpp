@@ -0,0 +1,60 @@
+// polygonfill.cpp
+#include "polygonfill.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+inline int floorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+}
+
+void PolygonFill::fill(GridCanvas& g, const QVector<QPoint>& points, QRgb c) {
+    const int n = points.size();
+    if (n < 3) return;
+
+    m_edges.clear();
+    m_active.clear();
+    int yMin = std::numeric_limits<int>::max();
+    int yMax = std::numeric_limits<int>::min();
+
+    for (int i = 0; i < n; ++i) {
+        const QPoint* v1 = &points[i];
+        const QPoint* v2 = &points[i + 1 < n ? i + 1 : 0];
+        yMin = std::min({yMin, v1->y(), v2->y()});
+        yMax = std::max({yMax, v1->y(), v2->y()});
+
+        if (v1->y() > v2->y()) std::swap(v1, v2);
+        if (v1->y() == v2->y()) continue;
+
+        Edge e;
+        e.yMin = v1->y();
+        e.yMax = v2->y();
+        e.dy = v2->y() - v1->y();
+        const int dx = v2->x() - v1->x();
+        e.stepI = floorDiv(dx, e.dy);
+        e.stepNum = dx - e.stepI * e.dy;
+        e.xi = v1->x();
+        e.num = 0;
+        m_edges.push_back(e);
+    }
+    std::sort(m_edges.begin(), m_edges.end(), [](const Edge& a, const Edge& b) { return a.yMin < b.yMin; });
+
+    size_t next = 0;
+    for (int y = yMin; y < yMax; ++y) {
+        while (next < m_edges.size() && m_edges[next].yMin == y) m_active.push_back(m_edges[next++]);
+        m_active.erase(std::remove_if(m_active.begin(), m_active.end(), [y](const Edge& e) { return e.yMax == y; }),
+                       m_active.end());
+
+        // the order barely changes from row to row, so insertion sort is close to one pass
+        for (size_t i = 1; i < m_active.size(); ++i) {
+            const Edge e = m_active[i];
+            size_t j = i;
+            for (; j > 0 && e.leftOf(m_active[j - 1]); --j) m_active[j] = m_active[j - 1];
+            m_active[j] = e;
+        }
+
+        for (size_t i = 0; i + 1 < m_active.size(); i += 2) {
+            g.hspan(y, m_active[i].ceilX(), m_active[i + 1].floorX(), c);
+        }
+        for (Edge& e : m_active) e.step();
+    }
+}
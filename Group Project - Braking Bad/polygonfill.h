@@ -0,0 +1,46 @@
+// polygonfill.h
+#ifndef POLYGONFILL_H
+#define POLYGONFILL_H
+
+#include <QVector>
+#include <QPoint>
+#include <QRgb>
+#include <vector>
+#include "gridcanvas.h"
+
+// Even-odd scanline fill of a polygon given in grid cells. Row y covers the
+// cells between each pair of edge crossings at y, from the ceiling of the
+// left one to the floor of the right one. The edge table and the active edge
+// list are flat vectors kept between calls, so a fill allocates nothing once
+// they have grown to the largest polygon drawn.
+class PolygonFill {
+public:
+    void fill(GridCanvas& g, const QVector<QPoint>& points, QRgb c);
+
+private:
+    // x along an edge as an exact fraction: x = xi + num / dy, 0 <= num < dy,
+    // stepped by stepI + stepNum / dy per row
+    struct Edge {
+        int yMin, yMax;
+        int xi, num;
+        int stepI, stepNum;
+        int dy;
+
+        void step() {
+            xi += stepI;
+            num += stepNum;
+            if (num >= dy) { num -= dy; ++xi; }
+        }
+        int ceilX() const  { return xi + (num > 0); }
+        int floorX() const { return xi; }
+        bool leftOf(const Edge& o) const {
+            if (xi != o.xi) return xi < o.xi;
+            return qint64(num) * o.dy < qint64(o.num) * dy;
+        }
+    };
+
+    std::vector<Edge> m_edges;    // by yMin
+    std::vector<Edge> m_active;   // crossing the current row, by x
+};
+
+#endif // POLYGONFILL_H
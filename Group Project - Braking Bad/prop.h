@@ -5,9 +5,13 @@
 #include <QVector>
 #include <QColor>
 #include <random>
-#include <QPainter>
-#include <QHash>
+#include <array>
+#include <vector>
 #include "constants.h"
+#include "terrainstore.h"
+#include "gridcanvas.h"
+#include "spritecache.h"
+#include "worldwindow.h"
 
 enum class PropType {
     Tree, Rock, Flower, Mushroom,
@@ -25,6 +29,7 @@ struct Prop {
     PropType type;
     int variant;
     bool flipped;
+    quint64 spriteKey = 0;   // set once the terrain under the prop is final
 };
 
 class PropSystem {
@@ -33,35 +38,68 @@ public:
 
     void maybeSpawnProp(int worldX, int groundGy, int levelIndex, float slope, std::mt19937& rng);
 
-    void draw(QPainter& p, int camX, int camY, int screenW, int screenH, const QHash<int,int>& heightMap);
+    // Resolves the sprites of the props in view, rasterizing any that are
+    // missing; draw() then only reads, so bands of one frame can be drawn
+    // concurrently.
+    void prepare(int camX, int camY, int screenW, int screenH, const TerrainStore& heightMap);
+    void draw(GridCanvas& p, const TerrainStore& heightMap) const;
 
+    // drops the props well behind minWorldX, e.g. the oldest terrain kept
     void prune(int minWorldX);
     void clear();
 
 private:
-    QVector<Prop> m_props;
+    // props by world X, one window per drawing layer: buildings at the back,
+    // everything else in front, so a frame draws the layers in turn and finds
+    // what is in view, or near a new prop, by binary search
+    static constexpr int LAYER_COUNT = 2;
+    static int layerOf(PropType type) { return type == PropType::Building ? 0 : 1; }
+    std::array<WorldWindow<Prop, &Prop::wx>, LAYER_COUNT> m_layers;
+    // the right-most prop spawned, for the spacing between props
+    bool m_hasProps = false;
+    int  m_lastPropX = 0;
+    void add(const Prop& prop);
+    // whether a prop of this type lies less than distance away from worldX
+    bool nearby(PropType type, int worldX, int distance) const;
+    // rasterized props, and the canvas a missing one is recorded on
+    SpriteCache m_sprites;
+    GridCanvas m_scratch;
 
-    void plot(QPainter& p, int gx, int gy, const QColor& c);
+    // what prepare() found in view, in drawing order; a null sprite means
+    // the prop is rasterized directly
+    struct Visible {
+        const GridSprite* sprite;
+        const Prop* prop;
+        int gx, gy;
+    };
+    std::vector<Visible> m_visible;
+
+    // 0 when the prop has to be drawn directly; settled tells whether the
+    // key can be kept, i.e. every ground column it depends on exists
+    quint64 spriteKey(const Prop& prop, const TerrainStore& heightMap, bool& settled) const;
+    void rasterize(GridCanvas& p, const Prop& prop, int gx, int gy, const TerrainStore& heightMap) const;
+
+    void plot(GridCanvas& p, int gx, int gy, const QColor& c) const;
 
     // Existing props
-    void drawTree(QPainter& p, int gx, int gy, int worldGX, int wx, int wy, int variant, const QHash<int,int>& heightMap);
-    void drawRock(QPainter& p, int gx, int gy, int variant);
-    void drawFlower(QPainter& p, int gx, int gy, int variant);
-    void drawMushroom(QPainter& p, int gx, int gy, int variant);
-    void drawCactus(QPainter& p, int gx, int gy, int variant);
-    void drawTumbleweed(QPainter& p, int gx, int gy, int variant);
-    void drawCamel(QPainter& p, int gx, int gy, int variant, bool flipped);
-    void drawIgloo(QPainter& p, int gx, int gy, int worldGX, int variant, const QHash<int,int>& heightMap);
-    void drawPenguin(QPainter& p, int gx, int gy, int variant, bool flipped);
-    void drawSnowman(QPainter& p, int gx, int gy, int variant);
-    void drawIceSpike(QPainter& p, int gx, int gy, int variant);
-    void drawUFO(QPainter& p, int gx, int gy, int variant);
-    void drawRover(QPainter& p, int gx, int gy, int worldGX, int variant, bool flipped, const QHash<int,int>& heightMap);
-    void drawAlien(QPainter& p, int gx, int gy, int variant);
+    void drawTree(GridCanvas& p, int gx, int gy, int worldGX, int wx, int wy, int variant, const TerrainStore& heightMap) const;
+    void drawRock(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawFlower(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawMushroom(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawCactus(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawTumbleweed(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawCamel(GridCanvas& p, int gx, int gy, int variant, bool flipped) const;
+    void drawIgloo(GridCanvas& p, int gx, int gy, int worldGX, int variant, const TerrainStore& heightMap) const;
+    void drawPenguin(GridCanvas& p, int gx, int gy, int variant, bool flipped) const;
+    void drawSnowman(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawIceSpike(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawUFO(GridCanvas& p, int gx, int gy, int variant) const;
+    void drawRover(GridCanvas& p, int gx, int gy, int worldGX, int variant, bool flipped, const TerrainStore& heightMap) const;
+    void drawAlien(GridCanvas& p, int gx, int gy, int variant) const;
 
     // Nightlife Drawing Functions
-    void drawBuilding(QPainter& p, int gx, int gy, int worldGX, int variant, const QHash<int,int>& heightMap);
-    void drawStreetLamp(QPainter& p, int gx, int gy, int worldGX, int variant, const QHash<int,int>& heightMap);
+    void drawBuilding(GridCanvas& p, int gx, int gy, int worldGX, int variant, const TerrainStore& heightMap) const;
+    void drawStreetLamp(GridCanvas& p, int gx, int gy, int worldGX, int variant, const TerrainStore& heightMap) const;
 };
 
 #endif // PROP_H
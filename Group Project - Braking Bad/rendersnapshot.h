@@ -0,0 +1,60 @@
+// rendersnapshot.h
+#ifndef RENDERSNAPSHOT_H
+#define RENDERSNAPSHOT_H
+
+#include <QVector>
+#include "line.h"
+#include "wheel.h"
+#include "carBody.h"
+#include "worlditems.h"
+#include "nitro.h"
+#include "flip.h"
+
+// Everything a frame draws of one round, copied out of the Simulation at the
+// end of its ticks (Simulation::fillSnapshot). The window keeps two: it draws
+// one while the simulation runs the next ticks on a worker thread and fills
+// the other, so rendering never reads state that is being written.
+struct RenderSnapshot {
+    // the body's shapes are copied once per round (see round); only where it
+    // sits is copied every frame
+    struct BodyPose {
+        CarShape shape;
+        double x = 0.0;
+        double y = 0.0;
+        double angle = 0.0;
+    };
+
+    // one change to the retained terrain, in the order the simulation made it
+    struct TerrainEdit {
+        Line segment;       // the segment appended, unless evict
+        float slope = 0.0f;
+        bool evict = false; // the oldest segment was dropped
+    };
+
+    // the Simulation round the body shapes were copied from
+    int round = -1;
+
+    double cameraX = 0.0;
+    double cameraY = 200.0;
+
+    QVector<WheelPose> wheels;
+    QVector<BodyPose>  bodies;
+
+    WorldItems  items;
+    NitroSystem nitroSys;
+    FlipTracker flip;
+
+    double elapsedSeconds = 0.0;
+    double fuel = 0.0;
+    double distanceMeters = 0.0;
+    int coinCount = 0;
+    int nitroUses = 0;
+    int score = 0;
+    bool over = false;
+
+    // filled by whoever listens to the simulation's terrain hooks and cleared
+    // once applied; fillSnapshot leaves it alone
+    QVector<TerrainEdit> terrainEdits;
+};
+
+#endif // RENDERSNAPSHOT_H
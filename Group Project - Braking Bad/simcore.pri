@@ -0,0 +1,11 @@
+# simcore.pri
+# Links a target against the simcore static library built alongside it.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH  += $$PWD
+
+win32-msvc*: SIMCORE_LIB = $$OUT_PWD/simcore.lib
+else:        SIMCORE_LIB = $$OUT_PWD/libsimcore.a
+
+LIBS += -L$$OUT_PWD -lsimcore
+PRE_TARGETDEPS += $$SIMCORE_LIB
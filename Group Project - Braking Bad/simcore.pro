@@ -0,0 +1,41 @@
+# simcore.pro
+# Physics, terrain generation and pickups, with no widgets or windowing.
+
+QT       = core gui
+CONFIG   += c++17 staticlib
+
+TARGET = simcore
+TEMPLATE = lib
+DESTDIR = $$OUT_PWD
+OBJECTS_DIR = .obj/simcore
+
+HEADERS += \
+    carBody.h \
+    coin.h \
+    constants.h \
+    flip.h \
+    fuel.h \
+    line.h \
+    nitro.h \
+    point.h \
+    rendersnapshot.h \
+    simulation.h \
+    terrainstore.h \
+    vehiclestate.h \
+    wheel.h \
+    worlditems.h \
+    worldwindow.h
+
+SOURCES += \
+    carBody.cpp \
+    coin.cpp \
+    flip.cpp \
+    fuel.cpp \
+    line.cpp \
+    nitro.cpp \
+    point.cpp \
+    simulation.cpp \
+    terrainstore.cpp \
+    vehiclestate.cpp \
+    wheel.cpp \
+    worlditems.cpp
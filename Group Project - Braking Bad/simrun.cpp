@@ -0,0 +1,272 @@
+// simrun.cpp
+// Headless runner: plays seeded, scripted episodes on the simulation core as fast as it will go.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <cstdio>
+#include <random>
+#include "simulation.h"
+#include "terrainshade.h"
+
+namespace {
+
+struct ScriptStep {
+    SimControls controls;
+    double seconds;
+};
+
+// "a:4,an:1,-:0.5" holds accelerate for 4 s, accelerate+nitro for 1 s, nothing for 0.5 s, then loops.
+// Keys: a = accelerate, b = brake, n = nitro, - = none.
+bool parseScript(const QString& spec, QVector<ScriptStep>& out) {
+    out.clear();
+    for (const QString& entry : spec.split(',', Qt::SkipEmptyParts)) {
+        const QStringList parts = entry.split(':');
+        if (parts.size() != 2) return false;
+        bool ok = false;
+        ScriptStep s;
+        s.seconds = parts[1].toDouble(&ok);
+        if (!ok || s.seconds <= 0.0) return false;
+        for (QChar c : parts[0]) {
+            if (c == 'a') s.controls.accelerate = true;
+            else if (c == 'b') s.controls.brake = true;
+            else if (c == 'n') s.controls.nitro = true;
+            else if (c != '-') return false;
+        }
+        out.append(s);
+    }
+    return !out.isEmpty();
+}
+
+// Nanoseconds per Wheel::simulate call for a wheel pressed into a gentle run
+// of segments. With perCall set the step factors are raised afresh for every
+// call, as they were before stepCar worked them out once per step.
+double timeWheelContacts(const BiomeParams& biome, const TerrainStore& terrain, int iterations, bool perCall, double& sink) {
+    VehicleState state;
+    Wheel wheel(state, 0, 0, int(Constants::WHEEL_REAR_R));
+    const int p = wheel.particle();
+    StepFactors factors = StepFactors::of(biome, 1.0);
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < iterations; ++i) {
+        wheel.x() = state.startX[p] = 600.0 + (i & 63);
+        wheel.y() = state.startY[p] = 500.0 - Constants::WHEEL_REAR_R + 3.0;
+        wheel.vx() = 2.0;
+        wheel.vy() = -1.0;
+        if (perCall) factors = StepFactors::of(biome, 1.0 + sink * 1e-300); // sink keeps pow in the loop
+        wheel.simulate(biome, factors, terrain, true, false, false, 1.0);
+        sink += wheel.vx() + wheel.y();
+    }
+    return double(clock.nsecsElapsed()) / iterations;
+}
+
+void benchmarkContacts(QTextStream& out, int iterations) {
+    TerrainStore terrain;
+    for (int i = 0; i < 64; ++i) {
+        terrain.append(Line(i * Constants::STEP, 500 + (i % 3), (i + 1) * Constants::STEP, 500 + ((i + 1) % 3)));
+    }
+    double sink = 0.0;
+    for (int b = 0; b < Constants::BIOME_COUNT; ++b) {
+        const BiomeParams& biome = Constants::BIOMES[b];
+        const double perCall = timeWheelContacts(biome, terrain, iterations, true, sink);
+        const double perStep = timeWheelContacts(biome, terrain, iterations, false, sink);
+        out << QString("level %1: factors per call %2 ns, per step %3 ns per wheel contact step (%4x)")
+                   .arg(b)
+                   .arg(perCall, 0, 'f', 1)
+                   .arg(perStep, 0, 'f', 1)
+                   .arg(perCall / std::max(perStep, 1e-9), 0, 'f', 2)
+            << Qt::endl;
+    }
+    if (sink == 0.123) out << Qt::endl; // keeps the loops observable
+}
+
+// The block hash and palette pick terrain shading used before TerrainShade,
+// kept as the benchmark baseline. The divisor is forced odd so the baseline
+// itself cannot trap on a zero divisor.
+int legacyIndex(int bx, int by) {
+    quint32 h = 120003212u;
+    h ^= quint32(bx); h *= 16777619u;
+    h ^= quint32(by); h *= 16777619u;
+    h = (h ^ bx) / ((h ^ by) | 1u) + (bx * by) - (3 * bx*bx + 4 * by*by);
+    return int(h % m_grassPalette.size());
+}
+
+QRgb legacyShade(int level, int gx, int gy, bool grass) {
+    const int i = legacyIndex(gx / Constants::SHADING_BLOCK, gy / Constants::SHADING_BLOCK);
+    return (grass ? m_grassPalette : m_dirtPalette)[level][i].rgb();
+}
+
+// Checks the vector shading kernel against the scalar reference cell for
+// cell, reports how evenly blocks spread over each palette, then times
+// legacy, scalar and vector shading. Returns the number of mismatched cells.
+long benchmarkShading(QTextStream& out, int columns) {
+    constexpr int RUN = 64;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> gxDist(-5000, 200000), groundDist(-400, 800);
+    std::uniform_int_distribution<int> depthDist(0, 120), lenDist(1, RUN);
+    QRgb a[RUN], b[RUN];
+
+    long mismatches = 0, cells = 0;
+    for (int level = 0; level < Constants::BIOME_COUNT; ++level) {
+        for (int c = 0; c < columns; ++c) {
+            const int gx = gxDist(rng), ground = groundDist(rng);
+            const int gy0 = ground + depthDist(rng), n = lenDist(rng);
+            TerrainShade::shadeColumn(a, gx, gy0, n, ground, level);
+            TerrainShade::shadeColumnScalar(b, gx, gy0, n, ground, level);
+            for (int i = 0; i < n; ++i) mismatches += (a[i] != b[i]);
+            cells += n;
+        }
+    }
+    out << QString("equivalence: %1 cells, %2 differ between vector and scalar shading").arg(cells).arg(mismatches) << Qt::endl;
+
+    for (int level = 0; level < Constants::BIOME_COUNT; ++level) {
+        const TerrainShade::Palette& pal = TerrainShade::palette(level);
+        QVector<int> hits(pal.grassLen, 0), legacyHits(pal.grassLen, 0);
+        for (int by = 0; by < 256; ++by) {
+            for (int bx = 0; bx < 256; ++bx) {
+                ++hits[TerrainShade::pick(TerrainShade::hash2D(bx, by), pal.grassLen)];
+                ++legacyHits[legacyIndex(bx, by)];
+            }
+        }
+        const auto [lo, hi] = std::minmax_element(hits.begin(), hits.end());
+        const int legacyUsed = int(std::count_if(legacyHits.begin(), legacyHits.end(), [](int h){ return h > 0; }));
+        out << QString("level %1: grass entries used %2/%3 (was %4), share per entry %5%-%6%")
+                   .arg(level).arg(hits.size() - std::count(hits.begin(), hits.end(), 0)).arg(pal.grassLen).arg(legacyUsed)
+                   .arg(100.0 * *lo / (256 * 256), 0, 'f', 1).arg(100.0 * *hi / (256 * 256), 0, 'f', 1)
+            << Qt::endl;
+    }
+
+    quint32 sink = 0;
+    auto timeIt = [&](const QString& name, auto&& shade) {
+        QElapsedTimer clock;
+        clock.start();
+        for (int c = 0; c < columns; ++c) {
+            shade(a, c * 7, 100 + (c & 31), RUN, 100);
+            sink += a[c & (RUN - 1)];
+        }
+        const double ns = double(clock.nsecsElapsed());
+        out << QString("%1: %2 Mcells/s").arg(name, -7).arg(double(columns) * RUN * 1e3 / std::max(ns, 1.0), 0, 'f', 1) << Qt::endl;
+    };
+    timeIt("legacy", [](QRgb* o, int gx, int gy0, int n, int ground) {
+        for (int i = 0; i < n; ++i) {
+            const int gy = gy0 + i;
+            o[i] = (gy == ground) ? QColor(legacyShade(0, gx, ground, true)).darker(115).rgb()
+                                  : legacyShade(0, gx, gy, gy < ground + 3 * Constants::SHADING_BLOCK);
+        }
+    });
+    timeIt("scalar", [](QRgb* o, int gx, int gy0, int n, int ground) { TerrainShade::shadeColumnScalar(o, gx, gy0, n, ground, 0); });
+    timeIt("vector", [](QRgb* o, int gx, int gy0, int n, int ground) { TerrainShade::shadeColumn(o, gx, gy0, n, ground, 0); });
+    if (sink == 0x12345678u) out << Qt::endl; // keeps the loops observable
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("simrun");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs Braking Bad physics episodes without a display.");
+    parser.addHelpOption();
+    QCommandLineOption levelOpt("level", "Stage index, 0-5.", "n", "0");
+    QCommandLineOption seedOpt("seed", "Seed of the first episode.", "n", "1");
+    QCommandLineOption episodesOpt("episodes", "Number of episodes; seeds count up from --seed.", "n", "1");
+    QCommandLineOption secondsOpt("seconds", "Simulated time limit per episode.", "s", "120");
+    QCommandLineOption hzOpt("hz", "Physics rate.", "n", QString::number(Constants::PHYSICS_HZ));
+    QCommandLineOption substepsOpt("substeps", "Car substeps per physics step.", "n", QString::number(Constants::PHYSICS_SUBSTEPS));
+    QCommandLineOption scriptOpt("script", "Looping input script, e.g. a:4,an:1,-:0.5 (a accel, b brake, n nitro).", "spec", "a:4,an:1");
+    QCommandLineOption widthOpt("width", "Viewport width the terrain generator sees.", "px", QString::number(Constants::LOGICAL_W_CELLS * Constants::PIXEL_SIZE));
+    QCommandLineOption benchOpt("bench-contacts", "Time wheel contacts with step factors raised per call vs once per step, then exit.", "iterations");
+    QCommandLineOption shadeOpt("bench-shading", "Check the vector terrain shading against the scalar one and time both, then exit.", "columns");
+    QCommandLineOption heightOpt("height", "Viewport height the terrain generator sees.", "px", QString::number(Constants::LOGICAL_H_CELLS * Constants::PIXEL_SIZE));
+    parser.addOptions({levelOpt, seedOpt, episodesOpt, secondsOpt, hzOpt, substepsOpt, scriptOpt, widthOpt, heightOpt, benchOpt, shadeOpt});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (parser.isSet(benchOpt)) {
+        benchmarkContacts(out, std::max(1, parser.value(benchOpt).toInt()));
+        return 0;
+    }
+    if (parser.isSet(shadeOpt)) {
+        return benchmarkShading(out, std::max(1, parser.value(shadeOpt).toInt())) == 0 ? 0 : 1;
+    }
+
+    const int level = parser.value(levelOpt).toInt();
+    if (level < 0 || level >= Constants::BIOME_COUNT) {
+        err << "level must be between 0 and " << (Constants::BIOME_COUNT - 1) << Qt::endl;
+        return 1;
+    }
+    QVector<ScriptStep> script;
+    if (!parseScript(parser.value(scriptOpt), script)) {
+        err << "bad --script: " << parser.value(scriptOpt) << Qt::endl;
+        return 1;
+    }
+    const quint32 firstSeed = parser.value(seedOpt).toUInt();
+    const int episodes = std::max(1, parser.value(episodesOpt).toInt());
+    const double limitSeconds = std::max(0.0, parser.value(secondsOpt).toDouble());
+
+    Simulation sim;
+    sim.setViewport(parser.value(widthOpt).toInt(), parser.value(heightOpt).toInt());
+    sim.setPhysicsHz(parser.value(hzOpt).toInt());
+    sim.setSubsteps(parser.value(substepsOpt).toInt());
+
+    quint64 totalTicks = 0;
+    qint64 totalNs = 0;
+
+    for (int e = 0; e < episodes; ++e) {
+        const quint32 seed = firstSeed + quint32(e);
+        sim.reset(level, seed);
+
+        int scriptIndex = 0;
+        double scriptLeft = script[0].seconds;
+        double overSince = -1.0;
+
+        QElapsedTimer clock;
+        clock.start();
+        while (sim.elapsedSeconds() < limitSeconds) {
+            sim.setControls(script[scriptIndex].controls);
+            sim.step();
+
+            scriptLeft -= sim.stepSeconds();
+            if (scriptLeft <= 0.0) {
+                scriptIndex = (scriptIndex + 1) % script.size();
+                scriptLeft += script[scriptIndex].seconds;
+            }
+
+            // the game only ends once the loss has held for the game-over delay
+            if (sim.isOver()) {
+                if (overSince < 0.0) overSince = sim.elapsedSeconds();
+                if (sim.elapsedSeconds() - overSince >= Constants::GAME_OVER_DELAY_MS / 1000.0) break;
+            } else {
+                overSince = -1.0;
+            }
+        }
+        const qint64 ns = std::max<qint64>(1, clock.nsecsElapsed());
+        totalTicks += sim.ticks();
+        totalNs += ns;
+
+        out << QString("episode %1 seed %2 level %3: distance %4 m, score %5, coins %6, flips %7, %8 ticks (%9 s simulated) in %10 ms, %11 ticks/s")
+                   .arg(e).arg(seed).arg(level)
+                   .arg(sim.distanceMeters(), 0, 'f', 1)
+                   .arg(sim.score()).arg(sim.coinCount()).arg(sim.flipTracker().total())
+                   .arg(sim.ticks()).arg(sim.elapsedSeconds(), 0, 'f', 1)
+                   .arg(ns / 1e6, 0, 'f', 1)
+                   .arg(sim.ticks() * 1e9 / ns, 0, 'f', 0)
+            << Qt::endl;
+    }
+
+    if (episodes > 1) {
+        out << QString("total: %1 ticks in %2 ms, %3 ticks/s")
+                   .arg(totalTicks)
+                   .arg(totalNs / 1e6, 0, 'f', 1)
+                   .arg(totalTicks * 1e9 / std::max<qint64>(1, totalNs), 0, 'f', 0)
+            << Qt::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+# simrun.pro
+# Headless episode runner for the simulation core.
+
+QT       = core gui
+CONFIG   += c++17 console
+CONFIG   -= app_bundle
+
+TARGET = simrun
+TEMPLATE = app
+OBJECTS_DIR = .obj/simrun
+
+include(simcore.pri)
+# for --bench-shading
+include(gridrender.pri)
+
+SOURCES += \
+    simrun.cpp
@@ -0,0 +1,388 @@
+// simulation.cpp
+#include "simulation.h"
+#include <cmath>
+#include <algorithm>
+
+Simulation::Simulation() {}
+
+Simulation::~Simulation() {
+    clearCar();
+}
+
+void Simulation::setViewport(int width, int height) {
+    m_viewW = std::max(width, Constants::STEP);
+    m_viewH = std::max(height, 1);
+}
+
+void Simulation::setPhysicsHz(int hz) {
+    m_physicsHz = std::clamp(hz, Constants::PHYSICS_HZ_MIN, Constants::PHYSICS_HZ_MAX);
+}
+
+void Simulation::setSubsteps(int substeps) {
+    m_substeps = std::clamp(substeps, 1, Constants::PHYSICS_SUBSTEPS_MAX);
+}
+
+void Simulation::reset(int levelIndex, quint32 seed) {
+    m_levelIndex = std::clamp(levelIndex, 0, Constants::BIOME_COUNT - 1);
+    ++m_round;
+    m_rng.seed(seed);
+    m_dist.reset();
+    m_controls = SimControls();
+
+    m_roofCrashLatched = false;
+
+    m_nitroSys = NitroSystem();
+    m_fuelSys  = FuelSystem();
+    m_coinSys  = CoinSystem();
+    m_items.clear();
+
+    m_fuel = Constants::FUEL_MAX;
+    m_coinCount = 0;
+    m_nitroUses = 0;
+    m_prevNitroActive = false;
+    m_elapsedSeconds = 0.0;
+    m_ticks = 0;
+    m_simAccumulator = 0.0;
+
+    m_camX = m_camY = m_camVX = m_camVY = 0.0;
+    m_prevCamX = m_prevCamY = 0.0;
+
+    m_terrain.clear();
+    m_lastX = 0;
+    m_lastY = 0;
+    m_slope = 0;
+    m_difficulty = Constants::INITIAL_DIFFICULTY[m_levelIndex];
+    m_irregularity = Constants::INITIAL_IRREGULARITY[m_levelIndex];
+    m_terrain_height = Constants::INITIAL_TERRAIN_HEIGHT[m_levelIndex];
+    generateInitialTerrain();
+
+    clearCar();
+    createCar();
+
+    m_totalDistanceCells = 0.0;
+    m_score = 0;
+
+    {
+        double ax = 0.0;
+        for (const Wheel* w : m_wheels) ax += w->x();
+        m_lastScoreX = m_wheels.isEmpty() ? 0.0 : ax / m_wheels.size();
+    }
+
+    m_flip.reset();
+}
+
+void Simulation::appendSegment(const Line& seg) {
+    m_terrain.append(seg);
+    if (onSegmentAppended) onSegmentAppended(seg, m_slope);
+}
+
+void Simulation::generateInitialTerrain() {
+    m_lastY = m_viewH / 2;
+
+    for (int i = Constants::STEP; i <= m_viewW + Constants::STEP; i += Constants::STEP) {
+
+        m_slope += (m_dist(m_rng) - (1 - m_terrain_height/100) * static_cast<float>(m_lastY) / m_viewH) * m_difficulty;
+        m_slope = std::clamp(m_slope, -(float)Constants::MAX_SLOPE[m_levelIndex], (float)Constants::MAX_SLOPE[m_levelIndex]);
+        const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), m_irregularity) * Constants::STEP);
+
+        appendSegment(Line(i - Constants::STEP, m_lastY, i, newY));
+
+        m_lastY = newY;
+        m_lastX = i;
+
+        m_difficulty += Constants::DIFFICULTY_INCREMENT[m_levelIndex];
+        m_irregularity += Constants::IRREGULARITY_INCREMENT[m_levelIndex];
+        if(m_terrain_height < 0.5) m_terrain_height += Constants::TERRAIN_HEIGHT_INCREMENT[m_levelIndex];
+    }
+    m_lastX = Constants::STEP * m_terrain.segmentCount();
+}
+
+void Simulation::ensureAheadTerrain(int worldX) {
+    while (m_lastX < worldX) {
+        m_slope += (m_dist(m_rng) - (1 - m_terrain_height/100) * static_cast<float>(m_lastY) / m_viewH) * m_difficulty;
+        m_slope = std::clamp(m_slope, -1.0f, 1.0f);
+
+        const int newY = m_lastY + std::lround(m_slope * std::pow(std::abs(m_slope), m_irregularity) * Constants::STEP);
+
+        appendSegment(Line(m_lastX, m_lastY, m_lastX + Constants::STEP, newY));
+
+        m_lastY = newY;
+        m_lastX += Constants::STEP;
+
+        if (m_terrain.segmentCount() > (m_viewW / Constants::STEP) * 3) {
+            m_terrain.evictFront();
+            if (onSegmentEvicted) onSegmentEvicted();
+            m_items.evictBefore(leftmostTerrainX());
+        }
+
+        m_difficulty += Constants::DIFFICULTY_INCREMENT[m_levelIndex];
+        m_irregularity += Constants::IRREGULARITY_INCREMENT[m_levelIndex];
+        if(m_terrain_height < 0.5) m_terrain_height += Constants::TERRAIN_HEIGHT_INCREMENT[m_levelIndex];
+        m_fuelSys.maybePlaceFuelAtEdge(m_items, m_lastX, m_terrain, m_difficulty, m_elapsedSeconds);
+    }
+}
+
+void Simulation::createCar() {
+    const BiomeParams& biome = Constants::BIOMES[m_levelIndex];
+    m_vehicles.setEnvironment(biome.gravity, biome.airResistance);
+
+    Wheel* w1 = new Wheel(m_vehicles, Constants::WHEEL_REAR_X,  Constants::WHEEL_REAR_Y,  Constants::WHEEL_REAR_R);
+    Wheel* w2 = new Wheel(m_vehicles, Constants::WHEEL_FRONT_X, Constants::WHEEL_FRONT_Y, Constants::WHEEL_FRONT_R);
+    Wheel* w3 = new Wheel(m_vehicles, Constants::WHEEL_MID_X,   Constants::WHEEL_MID_Y,   Constants::WHEEL_MID_R);
+
+    w1->attach(w2); w3->attach(w2); w1->attach(w3);
+    m_wheels.append(w1); m_wheels.append(w2); m_wheels.append(w3);
+
+    CarBody* body = new CarBody(m_vehicles);
+    body->addPoints(Constants::CAR_BODY_POINTS);
+    body->addHitbox(Constants::CAR_HITBOX_POINTS);
+    body->addKillSwitches(Constants::CAR_KILL_POINTS);
+
+    body->addWheel(w1); body->addWheel(w2); body->addWheel(w3);
+
+    body->addAttachment(Constants::CAR_GLASS_POINTS, Constants::CAR_GLASS_COLOR);
+    body->addAttachment(Constants::CAR_HANDLE_POINTS, Constants::CAR_HANDLE_COLOR);
+
+    body->finish();
+    m_bodies.append(body);
+}
+
+void Simulation::clearCar() {
+    qDeleteAll(m_wheels); m_wheels.clear();
+    qDeleteAll(m_bodies); m_bodies.clear();
+    m_vehicles.clear();
+}
+
+int Simulation::advance(double frameSeconds) {
+    const double dtStep = stepSeconds();
+    m_simAccumulator += std::max(0.0, frameSeconds);
+
+    int steps = 0;
+    while (m_simAccumulator >= dtStep && steps < Constants::MAX_STEPS_PER_FRAME) {
+        step();
+        m_simAccumulator -= dtStep;
+        ++steps;
+    }
+    // too far behind to catch up: drop the backlog rather than spiral
+    if (m_simAccumulator >= dtStep) m_simAccumulator = std::fmod(m_simAccumulator, dtStep);
+
+    return steps;
+}
+
+void Simulation::storePreviousState() {
+    m_vehicles.storePrevious();
+    for (CarBody* b : m_bodies) b->storePrevious();
+    m_prevCamX = m_camX;
+    m_prevCamY = m_camY;
+}
+
+void Simulation::fillSnapshot(RenderSnapshot& out) const {
+    const double alpha = renderAlpha();
+    out.cameraX = renderCameraX();
+    out.cameraY = renderCameraY();
+
+    out.wheels.resize(m_wheels.size());
+    for (int i = 0; i < m_wheels.size(); ++i) out.wheels[i] = m_wheels[i]->pose(alpha);
+    const bool newRound = out.round != m_round || out.bodies.size() != m_bodies.size();
+    out.round = m_round;
+    out.bodies.resize(m_bodies.size());
+    for (int i = 0; i < m_bodies.size(); ++i) {
+        RenderSnapshot::BodyPose& b = out.bodies[i];
+        if (newRound) b.shape = m_bodies[i]->shape();
+        m_bodies[i]->renderPose(0, 0, alpha, b.x, b.y, b.angle);
+    }
+
+    out.items    = m_items;
+    out.nitroSys = m_nitroSys;
+    out.flip     = m_flip;
+
+    out.elapsedSeconds = m_elapsedSeconds;
+    out.fuel           = m_fuel;
+    out.distanceMeters = distanceMeters();
+    out.coinCount      = m_coinCount;
+    out.nitroUses      = m_nitroUses;
+    out.score          = m_score;
+    out.over           = isOver();
+}
+
+double Simulation::renderCameraX() const {
+    return m_prevCamX + (m_camX - m_prevCamX) * renderAlpha();
+}
+
+double Simulation::renderCameraY() const {
+    return m_prevCamY + (m_camY - m_prevCamY) * renderAlpha();
+}
+
+void Simulation::stepCar(double stepScale, bool accelerating, bool braking, bool nitro) {
+    const BiomeParams& biome = Constants::BIOMES[m_levelIndex];
+
+    // per substep: free flight for every particle, then contacts, then the links between them
+    const double subScale = stepScale / m_substeps;
+    const StepFactors factors = StepFactors::of(biome, subScale);
+    for (int sub = 0; sub < m_substeps; ++sub) {
+        m_vehicles.integrate(subScale);
+        for (Wheel* w : m_wheels) w->simulate(biome, factors, m_terrain, accelerating, braking, nitro, subScale);
+        for (CarBody* b : m_bodies) b->simulate(biome, factors, m_terrain, accelerating, braking, subScale);
+        m_vehicles.solveLinks(subScale, Constants::LINK_DAMPING);
+    }
+}
+
+void Simulation::step() {
+    storePreviousState();
+
+    const double dt = stepSeconds();
+    const double stepScale = dt * Constants::PHYSICS_REFERENCE_HZ;
+
+    ++m_ticks;
+    m_elapsedSeconds += dt;
+    double avgX = 0.0, avgY = 0.0;
+    if (!m_wheels.isEmpty()) {
+        for (const Wheel* w : m_wheels) { avgX += w->x(); avgY += w->y(); }
+        avgX /= m_wheels.size();
+        avgY /= m_wheels.size();
+    }
+
+    double dx = std::max(0.0, avgX - m_lastScoreX);
+    m_totalDistanceCells += dx / double(Constants::PIXEL_SIZE);
+    m_lastScoreX = avgX;
+
+    m_score = int(std::llround(Constants::SCORE_DIST_PER_CELL * m_totalDistanceCells +
+                               Constants::SCORE_PER_COIN * m_coinCount +
+                               Constants::SCORE_PER_NITRO * m_nitroUses));
+
+    double bodyX = (!m_bodies.isEmpty()) ? m_bodies.first()->getX() : avgX;
+    double bodyY = (!m_bodies.isEmpty()) ? m_bodies.first()->getY() : avgY;
+    const double targetX = bodyX - 200.0;
+    const double targetY = -bodyY + m_viewH / 2.0;
+    updateCamera(targetX, targetY, dt);
+    const int cameraX = int(std::lround(m_camX));
+    double angleRad = 0.0;
+    if (m_wheels.size() >= 2) {
+        const double dx = (m_wheels[1]->x() - m_wheels[0]->x());
+        const double dy = (m_wheels[1]->y() - m_wheels[0]->y());
+        angleRad = std::atan2(dy, dx);
+    }
+
+    m_flip.update(angleRad, bodyX, bodyY, m_elapsedSeconds, [this](int bonus){ m_coinCount += bonus; });
+
+    const int viewRightX = cameraX + m_viewW;
+    const int marginPx   = Constants::COIN_SPAWN_MARGIN_CELLS * Constants::PIXEL_SIZE;
+    const int offRightX  = viewRightX + marginPx;
+    const int maxStreamWidthPx =
+        (Constants::COIN_GROUP_MAX - 1) * Constants::COIN_GROUP_STEP_MAX * Constants::PIXEL_SIZE;
+    ensureAheadTerrain(offRightX + maxStreamWidthPx + Constants::PIXEL_SIZE * 20);
+
+    m_coinSys.maybePlaceCoinStreamAtEdge(
+        m_items, m_elapsedSeconds, cameraX, m_viewW, m_terrain, m_lastX, m_rng, m_dist);
+
+    m_nitroSys.update(
+        m_controls.nitro, m_fuel, m_elapsedSeconds, avgX,
+        [this](int gx){ return this->groundGyNearestGX(gx); },
+        [this](double wx){ return this->terrainTangentAngleAtX(wx); }
+        );
+
+    if (m_nitroSys.active && !m_prevNitroActive) ++m_nitroUses;
+    m_prevNitroActive = m_nitroSys.active;
+
+    const bool allowInput = (m_fuel > 0.0);
+    bool accelDrive = false, brakeDrive = false, nitroDrive = false;
+
+    if (m_nitroSys.active && allowInput) {
+        accelDrive = false; brakeDrive = false; nitroDrive = true;
+    } else {
+        nitroDrive = false;
+        bool bothKeys = m_controls.accelerate && m_controls.brake;
+        if (allowInput) {
+            if (bothKeys) { accelDrive = true; brakeDrive = true; }
+            else { accelDrive = m_controls.accelerate; brakeDrive = m_controls.brake; }
+        } else { accelDrive = false; brakeDrive = false; }
+    }
+
+    stepCar(stepScale, accelDrive, brakeDrive, nitroDrive);
+    for (CarBody* b : m_bodies) b->updateWorld();
+
+    m_nitroSys.applyThrust(m_wheels, stepScale);
+
+    if (m_fuel > 0.0) {
+        double baseBurn = Constants::FUEL_BASE_BURN_PER_SEC * dt;
+        double extra = 0.0;
+        if (m_controls.accelerate) extra = std::max(0.0, averageSpeed()) * Constants::FUEL_EXTRA_PER_SPEED * dt;
+        double burnMult = m_nitroSys.active ? 3.0 : 1.0;
+        m_fuel = std::max(0.0, m_fuel - burnMult * (baseBurn + extra));
+    }
+
+    const int minX = leftmostTerrainX();
+    for (Wheel* w : m_wheels) {
+        if (w->x() < minX) { w->x() = minX; w->vx() = 0; }
+    }
+
+    // the wheels collect only while the car is not on its roof; the body always does
+    const QList<Wheel*> noWheels;
+    const auto collected = m_items.collect(isFullyUpsideDown() ? noWheels : m_wheels, m_bodies);
+    if (collected[size_t(ItemKind::FuelCan)] > 0) m_fuel = Constants::FUEL_MAX;
+    m_coinCount += collected[size_t(ItemKind::Coin)];
+
+    const bool roofHit = !m_bodies.isEmpty() && !m_bodies[0]->isAlive();
+    if (roofHit && !m_roofCrashLatched) {
+        m_roofCrashLatched = true;
+    }
+}
+
+void Simulation::updateCamera(double tx, double ty, double dt) {
+    const double wn = m_camWN;
+    const double z  = m_camZeta;
+    const double ax = wn*wn * (tx - m_camX) - 2.0*z*wn * m_camVX;
+    m_camVX += ax * dt;
+    m_camX  += m_camVX * dt;
+    const double ay = wn*wn * (ty - m_camY) - 2.0*z*wn * m_camVY;
+    m_camVY += ay * dt;
+    m_camY  += m_camVY * dt;
+}
+
+int Simulation::leftmostTerrainX() const {
+    if (m_terrain.isEmpty()) return 0;
+    return m_terrain.front().getX1();
+}
+
+double Simulation::averageSpeed() const {
+    if (m_wheels.isEmpty()) return 0.0;
+    double s = 0.0;
+    for (const Wheel* w : m_wheels) s += std::sqrt(w->vx()*w->vx() + w->vy()*w->vy());
+    return s / m_wheels.size();
+}
+
+int Simulation::groundGyNearestGX(int gx) const {
+    return m_terrain.nearestHeight(gx);
+}
+
+double Simulation::terrainTangentAngleAtX(double wx) const {
+    int gx = int(wx / Constants::PIXEL_SIZE);
+    int gyL = groundGyNearestGX(gx - 1);
+    int gyR = groundGyNearestGX(gx + 1);
+    double dyCells = double(gyR - gyL);
+    return std::atan2(-dyCells, 2.0);
+}
+
+bool Simulation::isFullyUpsideDown() const {
+    if (m_wheels.size() < 2) return false;
+    const double dx = m_wheels[1]->x() - m_wheels[0]->x();
+    const double dy = m_wheels[1]->y() - m_wheels[0]->y();
+    const double len = std::hypot(dx, dy) + 1e-9;
+    const double c = dx / len;
+    const double s = dy / len;
+    return (c <= Constants::FLIPPED_COS_MIN && std::abs(s) <= Constants::FLIPPED_SIN_MAX);
+}
+
+bool Simulation::isRoofTouchingTerrain() const {
+    if (m_bodies.isEmpty()) return false;
+    const QVector<QPoint>& probes = m_bodies.front()->getKillSwitches();
+    const double tol = 0.5 * Constants::PIXEL_SIZE;
+    int onGround = 0;
+    for (const QPoint& pt : probes) {
+        const int gx = int(std::lround(double(pt.x()) / Constants::PIXEL_SIZE));
+        const int gyGround = groundGyNearestGX(gx);
+        const double wyGround = gyGround * Constants::PIXEL_SIZE;
+        if (pt.y() >= wyGround - tol) ++onGround;
+    }
+    return onGround >= 1;
+}
@@ -0,0 +1,167 @@
+// simulation.h
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QList>
+#include <functional>
+#include <random>
+
+#include "constants.h"
+#include "line.h"
+#include "terrainstore.h"
+#include "vehiclestate.h"
+#include "wheel.h"
+#include "carBody.h"
+#include "coin.h"
+#include "fuel.h"
+#include "nitro.h"
+#include "flip.h"
+#include "rendersnapshot.h"
+
+// Driver input held for the following physics steps.
+struct SimControls {
+    bool accelerate = false;
+    bool brake      = false;
+    bool nitro      = false;
+};
+
+// One round of the game without any widget: terrain generation, the car,
+// fuel, coins, nitro and flips. The game window and the headless runner both drive it.
+class Simulation {
+public:
+    Simulation();
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    // Called for every terrain segment appended, with the slope that produced it.
+    // Decorations (props, clouds) hang off this and must not touch the simulation rng.
+    std::function<void(const Line& segment, float slope)> onSegmentAppended;
+    // Called after the oldest terrain segment is dropped.
+    std::function<void()> onSegmentEvicted;
+
+    // Terrain generation and the camera follow the visible area, as they did in the window.
+    void setViewport(int width, int height);
+    void setPhysicsHz(int hz);
+    int  physicsHz() const { return m_physicsHz; }
+    double stepSeconds() const { return 1.0 / m_physicsHz; }
+    // the car (integration, contacts and links) is advanced in this many
+    // equal parts per step; more substeps keep stiff links stable at low rates
+    void setSubsteps(int substeps);
+    int  substeps() const { return m_substeps; }
+
+    void reset(int levelIndex, quint32 seed);
+    void setControls(const SimControls& controls) { m_controls = controls; }
+
+    // Advances exactly one fixed step.
+    void step();
+    // Feeds wall-clock time into the accumulator and runs as many fixed steps as fit,
+    // at most MAX_STEPS_PER_FRAME. Returns the number of steps run.
+    int advance(double frameSeconds);
+    // Where rendering sits between the last two steps, from 0 (previous) to 1 (current).
+    double renderAlpha() const { return m_simAccumulator * m_physicsHz; }
+    // Copies what a frame draws into out, blended at renderAlpha(); out.terrainEdits is untouched.
+    // The body shapes are only copied the first time out sees a round.
+    void fillSnapshot(RenderSnapshot& out) const;
+    void resetClock() { m_simAccumulator = 0.0; }
+
+    bool isOver() const { return m_fuel <= 0.0 || m_roofCrashLatched; }
+
+    const TerrainStore&    terrain() const { return m_terrain; }
+    const VehicleState&    vehicles() const { return m_vehicles; }
+    const QList<Wheel*>&   wheels()  const { return m_wheels; }
+    const QList<CarBody*>& bodies()  const { return m_bodies; }
+    const WorldItems&  items()       const { return m_items; }
+    const NitroSystem& nitroSystem() const { return m_nitroSys; }
+    const FlipTracker& flipTracker() const { return m_flip; }
+
+    int    levelIndex()     const { return m_levelIndex; }
+    double elapsedSeconds() const { return m_elapsedSeconds; }
+    double fuel()           const { return m_fuel; }
+    int    coinCount()      const { return m_coinCount; }
+    int    nitroUses()      const { return m_nitroUses; }
+    int    score()          const { return m_score; }
+    quint64 ticks()         const { return m_ticks; }
+    double totalDistanceCells() const { return m_totalDistanceCells; }
+    double distanceMeters() const { return (m_totalDistanceCells * Constants::PIXEL_SIZE) / 100.0; }
+
+    double cameraX() const { return m_camX; }
+    double cameraY() const { return m_camY; }
+    double renderCameraX() const;
+    double renderCameraY() const;
+
+    int groundGyNearestGX(int gx) const;
+    double terrainTangentAngleAtX(double wx) const;
+    int leftmostTerrainX() const;
+    double averageSpeed() const;
+    bool isFullyUpsideDown() const;
+    bool isRoofTouchingTerrain() const;
+
+private:
+    void generateInitialTerrain();
+    void appendSegment(const Line& seg);
+    void ensureAheadTerrain(int worldX);
+    void createCar();
+    void clearCar();
+    void storePreviousState();
+    void updateCamera(double targetX, double targetY, double dtSeconds);
+
+    // car integration, contacts and links for the current stage
+    void stepCar(double stepScale, bool accelerating, bool braking, bool nitro);
+
+    int m_viewW = 1280;
+    int m_viewH = 720;
+    int m_physicsHz = Constants::PHYSICS_HZ;
+    int m_substeps = Constants::PHYSICS_SUBSTEPS;
+    double m_simAccumulator = 0.0;
+    int m_levelIndex = 0;
+    // counts reset() calls; fillSnapshot() recopies the body shapes when it moves on
+    int m_round = 0;
+
+    SimControls m_controls;
+
+    std::mt19937 m_rng;
+    std::uniform_real_distribution<float> m_dist{0.0f, 1.0f};
+
+    TerrainStore    m_terrain;
+    VehicleState    m_vehicles;
+    QList<Wheel*>   m_wheels;
+    QList<CarBody*> m_bodies;
+
+    int   m_lastX = 0;
+    int   m_lastY = 0;
+    float m_slope = 0.0f;
+    double m_difficulty = 0.0;
+    double m_irregularity = 0.0;
+    double m_terrain_height = 0.0;
+
+    double m_camX  = 0.0;
+    double m_camY  = 0.0;
+    double m_camVX = 0.0;
+    double m_camVY = 0.0;
+    double m_camWN   = 20.0;
+    double m_camZeta = 0.98;
+    double m_prevCamX = 0.0;
+    double m_prevCamY = 0.0;
+
+    FuelSystem  m_fuelSys;
+    CoinSystem  m_coinSys;
+    WorldItems  m_items;
+    NitroSystem m_nitroSys;
+    FlipTracker m_flip;
+
+    double m_elapsedSeconds = 0.0;
+    quint64 m_ticks = 0;
+    double m_fuel = Constants::FUEL_MAX;
+    int m_coinCount = 0;
+    int m_nitroUses = 0;
+    bool m_prevNitroActive = false;
+    bool m_roofCrashLatched = false;
+
+    double m_lastScoreX = 0.0;
+    double m_totalDistanceCells = 0.0;
+    int m_score = 0;
+};
+
+#endif // SIMULATION_H
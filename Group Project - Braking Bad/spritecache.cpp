@@ -0,0 +1,55 @@
+// spritecache.cpp
+#include "spritecache.h"
+
+quint64 SpriteCache::key(std::initializer_list<qint64> parts) {
+    // splitmix64 finaliser over a running sum, so the order of the parts matters
+    quint64 h = 0x9e3779b97f4a7c15ull;
+    for (qint64 v : parts) {
+        h += quint64(v) + 0x9e3779b97f4a7c15ull;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+const GridSprite* SpriteCache::find(quint64 k) {
+    auto it = m_entries.find(k);
+    if (it == m_entries.end()) return nullptr;
+    it->second.lastUsed = m_frame;
+    return &it->second.sprite;
+}
+
+const GridSprite& SpriteCache::insert(quint64 k, GridSprite sprite) {
+    GridSprite& s = slot(k);
+    s = std::move(sprite);
+    return s;
+}
+
+GridSprite& SpriteCache::slot(quint64 k) {
+    Entries::iterator it;
+    if (m_spare.empty()) {
+        it = m_entries.try_emplace(k).first;
+    } else {
+        Entries::node_type node = std::move(m_spare.back());
+        m_spare.pop_back();
+        node.key() = k;
+        it = m_entries.insert(std::move(node)).position;
+    }
+    it->second.lastUsed = m_frame;
+    return it->second.sprite;
+}
+
+void SpriteCache::nextFrame() {
+    ++m_frame;
+    if (m_frame % KEEP_FRAMES != 0) return;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (m_frame - it->second.lastUsed > KEEP_FRAMES) m_spare.push_back(m_entries.extract(it++));
+        else ++it;
+    }
+}
+
+void SpriteCache::clear() {
+    while (!m_entries.empty()) m_spare.push_back(m_entries.extract(m_entries.begin()));
+    m_frame = 0;
+}
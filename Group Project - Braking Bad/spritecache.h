@@ -0,0 +1,47 @@
+// spritecache.h
+#ifndef SPRITECACHE_H
+#define SPRITECACHE_H
+
+#include <QtGlobal>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+#include "gridcanvas.h"
+
+// Sprites rasterized on first use and reused on later frames. Callers fold
+// everything a sprite's look depends on into a 64-bit key with key(); entries
+// nobody has asked for in a while are dropped so per-instance sprites (props
+// shaped by the terrain under them) do not pile up behind the camera. Dropped
+// entries keep their map node and texels for the next slot(), so a cache
+// that has reached its working size allocates nothing on a miss.
+class SpriteCache {
+public:
+    static quint64 key(std::initializer_list<qint64> parts);
+
+    // the sprite stored under k, or nullptr. Entries are never moved, so the
+    // pointer stays valid until nextFrame() drops the entry or clear().
+    const GridSprite* find(quint64 k);
+    const GridSprite& insert(quint64 k, GridSprite sprite);
+    // a sprite stored under k for the caller to draw into in place, e.g. with
+    // GridCanvas::takeSprite(ax, ay, out); k must not be stored yet
+    GridSprite& slot(quint64 k);
+
+    // once per frame; every KEEP_FRAMES frames, drops what went unused
+    void nextFrame();
+    void clear();
+    int size() const { return int(m_entries.size()); }
+
+    static constexpr quint32 KEEP_FRAMES = 240;
+
+private:
+    struct Entry {
+        GridSprite sprite;
+        quint32 lastUsed = 0;
+    };
+    using Entries = std::unordered_map<quint64, Entry>;
+    Entries m_entries;
+    std::vector<Entries::node_type> m_spare;   // dropped entries, for slot() to reuse
+    quint32 m_frame = 0;
+};
+
+#endif // SPRITECACHE_H
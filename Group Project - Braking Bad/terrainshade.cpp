@@ -0,0 +1,133 @@
+// terrainshade.cpp
+#include "terrainshade.h"
+#include "constants.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TERRAINSHADE_SSE2 1
+#endif
+
+namespace TerrainShade {
+
+namespace {
+
+constexpr int BLOCK = Constants::SHADING_BLOCK;
+constexpr int GRASS_ROWS = 3 * BLOCK;
+constexpr quint32 KX = 0x8da6b343u;   // must match hash2D
+constexpr quint32 KY = 0xd8163841u;
+
+inline int floorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+#ifdef TERRAINSHADE_SSE2
+// low 32 bits of a * b per lane; SSE2 only multiplies the even lanes
+inline __m128i mul32(__m128i a, __m128i b) {
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// the finaliser of hash2D on four lanes
+inline __m128i mixLanes(__m128i h) {
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    h = mul32(h, _mm_set1_epi32(int(0x7feb352du)));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = mul32(h, _mm_set1_epi32(int(0x846ca68bu)));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+}
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+} // namespace
+
+const Palette& palette(int level) {
+    static const std::vector<Palette> palettes = [] {
+        std::vector<Palette> out;
+        for (int l = 0; l < m_grassPalette.size(); ++l) {
+            const QVector<QColor>& grass = m_grassPalette[l];
+            const QVector<QColor>& dirt  = m_dirtPalette[l];
+            Palette p;
+            p.grassLen = int(grass.size());
+            p.dirtLen  = int(dirt.size());
+            for (const QColor& c : grass) p.lut.push_back(c.rgb());
+            for (const QColor& c : grass) p.lut.push_back(c.darker(115).rgb());
+            for (const QColor& c : dirt)  p.lut.push_back(c.rgb());
+            out.push_back(p);
+        }
+        return out;
+    }();
+    return palettes[std::clamp(level, 0, int(palettes.size()) - 1)];
+}
+
+QRgb blockColor(int level, int gx, int gy, bool grass) {
+    const Palette& pal = palette(level);
+    const quint32 h = hash2D(floorDiv(gx, BLOCK), floorDiv(gy, BLOCK));
+    return grass ? pal.grass(pick(h, pal.grassLen)) : pal.dirt(pick(h, pal.dirtLen));
+}
+
+void shadeColumnScalar(QRgb* out, int gx, int gy0, int n, int groundGY, int level) {
+    const Palette& pal = palette(level);
+    const int bx = floorDiv(gx, BLOCK);
+    for (int i = 0; i < n; ++i) {
+        const int gy = gy0 + i;
+        const quint32 h = hash2D(bx, floorDiv(gy, BLOCK));
+        if (gy == groundGY)                     out[i] = pal.edge(pick(h, pal.grassLen));
+        else if (gy < groundGY + GRASS_ROWS)    out[i] = pal.grass(pick(h, pal.grassLen));
+        else                                    out[i] = pal.dirt(pick(h, pal.dirtLen));
+    }
+}
+
+void shadeColumn(QRgb* out, int gx, int gy0, int n, int groundGY, int level) {
+    int i = 0;
+
+#ifdef TERRAINSHADE_SSE2
+    const Palette& pal = palette(level);
+    const quint32 hx = quint32(floorDiv(gx, BLOCK)) * KX;
+    int by = floorDiv(gy0, BLOCK);
+    int phase = gy0 - by * BLOCK;   // row of gy0 inside its block
+
+    // y term of the hash for eight consecutive cells, relative to the block
+    // of the first one, for each phase that cell can start at
+    alignas(16) quint32 yTerm[BLOCK][8];
+    for (int p = 0; p < BLOCK; ++p)
+        for (int k = 0; k < 8; ++k) yTerm[p][k] = quint32((p + k) / BLOCK) * KY;
+
+    const __m128i lane     = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i ground   = _mm_set1_epi32(groundGY);
+    const __m128i grassEnd = _mm_set1_epi32(groundGY + GRASS_ROWS);
+    const __m128i grassLen = _mm_set1_epi32(pal.grassLen);
+    const __m128i dirtLen  = _mm_set1_epi32(pal.dirtLen);
+    const __m128i edgeBase = _mm_set1_epi32(pal.grassLen);
+    const __m128i dirtBase = _mm_set1_epi32(2 * pal.grassLen);
+    alignas(16) qint32 index[8];
+
+    for (; i + 8 <= n; i += 8) {
+        const __m128i hBase = _mm_set1_epi32(int(hx + quint32(by) * KY));
+        for (int half = 0; half < 2; ++half) {
+            const __m128i yOff = _mm_load_si128(reinterpret_cast<const __m128i*>(yTerm[phase] + 4 * half));
+            const __m128i h    = mixLanes(_mm_add_epi32(hBase, yOff));
+            const __m128i gy   = _mm_add_epi32(_mm_set1_epi32(gy0 + i + 4 * half), lane);
+
+            const __m128i isGrass = _mm_cmplt_epi32(gy, grassEnd);
+            const __m128i isEdge  = _mm_cmpeq_epi32(gy, ground);
+            // pick(): both factors fit in 16 bits, so the high half of a 16-bit multiply is the index
+            const __m128i len  = select(isGrass, grassLen, dirtLen);
+            const __m128i slot = _mm_mulhi_epu16(_mm_srli_epi32(h, 16), len);
+            const __m128i base = select(isEdge, edgeBase, _mm_andnot_si128(isGrass, dirtBase));
+            _mm_store_si128(reinterpret_cast<__m128i*>(index + 4 * half), _mm_add_epi32(slot, base));
+        }
+        for (int k = 0; k < 8; ++k) out[i + k] = pal.lut[index[k]];
+
+        by += (phase + 8) / BLOCK;
+        phase = (phase + 8) % BLOCK;
+    }
+#endif
+
+    shadeColumnScalar(out + i, gx, gy0 + i, n - i, groundGY, level);
+}
+
+} // namespace TerrainShade
@@ -0,0 +1,52 @@
+// terrainshade.h
+#ifndef TERRAINSHADE_H
+#define TERRAINSHADE_H
+
+#include <QRgb>
+#include <vector>
+
+// Ground colouring shared by the game and the intro backdrop. Cells are
+// grouped into SHADING_BLOCK x SHADING_BLOCK blocks; each block takes a
+// palette entry picked by hashing its block coordinates. The top three
+// blocks of a column use the grass palette, with a darker tone on the surface
+// row, and everything under them the dirt palette.
+namespace TerrainShade {
+
+// Well-mixed 32-bit hash of a cell or block position, using only
+// multiplies, shifts and xors.
+inline quint32 hash2D(int x, int y) {
+    quint32 h = quint32(x) * 0x8da6b343u + quint32(y) * 0xd8163841u;
+    h ^= h >> 16; h *= 0x7feb352du;
+    h ^= h >> 15; h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Maps a hash onto [0, len) with a multiply instead of a modulus.
+inline int pick(quint32 h, int len) { return int(((h >> 16) * quint32(len)) >> 16); }
+
+// A stage's palettes as one packed table: grass, then the grass edge tones,
+// then dirt.
+struct Palette {
+    std::vector<QRgb> lut;
+    int grassLen = 0;
+    int dirtLen = 0;
+
+    QRgb grass(int i) const { return lut[i]; }
+    QRgb edge(int i) const  { return lut[grassLen + i]; }
+    QRgb dirt(int i) const  { return lut[2 * grassLen + i]; }
+};
+const Palette& palette(int level);
+
+// Colour of the block holding cell (gx, gy).
+QRgb blockColor(int level, int gx, int gy, bool grass);
+
+// Colours cells gy0 .. gy0+n-1 of column gx, whose surface is at groundGY,
+// into out[0 .. n). Eight cells per iteration on SSE2, scalar elsewhere.
+void shadeColumn(QRgb* out, int gx, int gy0, int n, int groundGY, int level);
+// One cell at a time; the reference the vector path must match exactly.
+void shadeColumnScalar(QRgb* out, int gx, int gy0, int n, int groundGY, int level);
+
+}
+
+#endif // TERRAINSHADE_H
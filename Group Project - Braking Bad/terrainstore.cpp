@@ -0,0 +1,86 @@
+#include "terrainstore.h"
+#include <cmath>
+#include <algorithm>
+
+void TerrainStore::clear() {
+    m_segments.clear();
+    m_heights.clear();
+    m_baseGX = 0;
+}
+
+void TerrainStore::append(const Line& seg) {
+    m_segments.pushBack(seg);
+
+    int x1 = seg.getX1(), y1 = seg.getY1();
+    int x2 = seg.getX2(), y2 = seg.getY2();
+    if (x2 < x1) { std::swap(x1,x2); std::swap(y1,y2); }
+
+    const int gx1 = x1 / Constants::PIXEL_SIZE;
+    const int gx2 = x2 / Constants::PIXEL_SIZE;
+
+    if (x2 == x1) {
+        setHeight(gx1, static_cast<int>(std::floor(y1 / double(Constants::PIXEL_SIZE) + 0.5)));
+        return;
+    }
+
+    const double dx = double(x2 - x1);
+    const double dy = double(y2 - y1);
+
+    for (int gx = gx1; gx <= gx2; ++gx) {
+        const double wx = gx * double(Constants::PIXEL_SIZE);
+        double t = (wx - x1) / dx;
+        t = std::clamp(t, 0.0, 1.0);
+
+        const double wy = y1 + t * dy;
+        setHeight(gx, static_cast<int>(std::floor(wy / double(Constants::PIXEL_SIZE) + 0.5)));
+    }
+}
+
+void TerrainStore::evictFront() {
+    if (m_segments.isEmpty()) return;
+    m_segments.popFront();
+    if (m_segments.isEmpty()) return;
+
+    const int keepFromGX = (m_segments.front().getX1() / Constants::PIXEL_SIZE) - 4;
+    if (keepFromGX > m_baseGX) {
+        const int drop = std::min(keepFromGX - m_baseGX, m_heights.size());
+        m_heights.popFront(drop);
+        m_baseGX += drop;
+    }
+}
+
+void TerrainStore::setHeight(int gx, int gy) {
+    if (m_heights.isEmpty()) m_baseGX = gx;
+    if (gx < m_baseGX) return;
+
+    if (gx < endGX()) {
+        m_heights[gx - m_baseGX] = gy;
+        return;
+    }
+    while (endGX() <= gx) m_heights.pushBack(gy);
+}
+
+std::pair<int, int> TerrainStore::range(double minX, double maxX) const {
+    const int n = m_segments.size();
+    if (n == 0 || maxX < minX) return {0, 0};
+
+    // segments share the fixed Constants::STEP pitch, starting at the oldest X1;
+    // a point sitting exactly on a joint touches both neighbouring segments
+    const int originX = m_segments.front().getX1();
+    int first = int(std::floor((minX - originX) / Constants::STEP));
+    if (std::fmod(minX - originX, double(Constants::STEP)) == 0.0) --first;
+    int last = int(std::floor((maxX - originX) / Constants::STEP)) + 1;
+
+    first = std::clamp(first, 0, n);
+    last  = std::clamp(last, first, n);
+    return {first, last};
+}
+
+int TerrainStore::nearestHeight(int gx) const {
+    if (m_heights.isEmpty()) return 0;
+    if (hasHeight(gx)) return heightAt(gx);
+
+    // the stored columns are contiguous, so the closest one is an end of the window
+    if (gx < m_baseGX) return (m_baseGX - gx <= 8) ? m_heights.front() : 0;
+    return (gx - (endGX() - 1) <= 8) ? m_heights.back() : 0;
+}
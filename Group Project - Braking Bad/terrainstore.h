@@ -0,0 +1,88 @@
+#ifndef TERRAINSTORE_H
+#define TERRAINSTORE_H
+
+#include <vector>
+#include <utility>
+#include "line.h"
+#include "constants.h"
+
+// Fixed-order FIFO over a power-of-two circular array. Indices are relative to
+// the oldest element; the storage doubles when full so pushes stay O(1) amortized.
+template <typename T>
+class RingBuffer {
+public:
+    int  size() const    { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    void clear()         { m_head = 0; m_size = 0; }
+
+    const T& operator[](int i) const { return m_data[(m_head + i) & m_mask]; }
+    T&       operator[](int i)       { return m_data[(m_head + i) & m_mask]; }
+    const T& front() const { return (*this)[0]; }
+    const T& back() const  { return (*this)[m_size - 1]; }
+
+    void pushBack(const T& v) {
+        if (m_size == int(m_data.size())) grow();
+        m_data[(m_head + m_size) & m_mask] = v;
+        ++m_size;
+    }
+
+    void popFront(int n = 1) {
+        if (n > m_size) n = m_size;
+        m_head = (m_head + n) & m_mask;
+        m_size -= n;
+    }
+
+private:
+    void grow() {
+        std::vector<T> next(m_data.empty() ? 64 : m_data.size() * 2);
+        for (int i = 0; i < m_size; ++i) next[i] = (*this)[i];
+        m_data.swap(next);
+        m_head = 0;
+        m_mask = int(m_data.size()) - 1;
+    }
+
+    std::vector<T> m_data;
+    int m_head = 0;
+    int m_size = 0;
+    int m_mask = 0;
+};
+
+// The retained terrain window: the polyline segments, oldest first, and the
+// ground height (in grid rows) of every grid column they cover. Terrain only
+// grows on the right and is dropped on the left, so both live in ring buffers
+// and the height of column gx sits at offset gx - baseGX().
+class TerrainStore {
+public:
+    void clear();
+
+    // Appends the next segment of the polyline and rasterizes it into the height columns.
+    void append(const Line& seg);
+    // Drops the oldest segment and the height columns that fell behind it.
+    void evictFront();
+
+    bool isEmpty() const      { return m_segments.isEmpty(); }
+    int  segmentCount() const { return m_segments.size(); }
+    const Line& segment(int i) const { return m_segments[i]; }
+    const Line& front() const { return m_segments.front(); }
+    const Line& back() const  { return m_segments.back(); }
+
+    // Index range [first, last) of the segments whose X extent overlaps [minX, maxX].
+    std::pair<int, int> range(double minX, double maxX) const;
+
+    int  baseGX() const { return m_baseGX; }
+    int  endGX() const  { return m_baseGX + m_heights.size(); }
+    bool hasHeight(int gx) const { return gx >= m_baseGX && gx < endGX(); }
+    int  heightAt(int gx) const  { return m_heights[gx - m_baseGX]; }
+    int  heightAt(int gx, int fallback) const { return hasHeight(gx) ? heightAt(gx) : fallback; }
+    // Height of the closest stored column at most 8 columns away, or 0.
+    int  nearestHeight(int gx) const;
+
+private:
+    void setHeight(int gx, int gy);
+
+    RingBuffer<Line> m_segments;
+    RingBuffer<int>  m_heights;
+    int m_baseGX = 0;
+};
+
+#endif // TERRAINSTORE_H
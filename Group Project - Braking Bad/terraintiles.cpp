@@ -0,0 +1,162 @@
+// terraintiles.cpp
+#include "terraintiles.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+// rounds towards negative infinity, so cells above row 0 land in tile row -1
+inline int floorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+}
+
+void TerrainTiles::reset(Shader shade) {
+    m_shade = std::move(shade);
+    for (int i = 0; i < m_cols.size(); ++i) retire(m_cols[i]);
+    m_cols.clear();
+    m_baseTX = 0;
+    m_nextGX = std::numeric_limits<int>::min();
+}
+
+void TerrainTiles::extend(const TerrainStore& terrain) {
+    if (terrain.isEmpty() || !m_shade) return;
+    for (int gx = std::max(m_nextGX, terrain.baseGX()); gx < terrain.endGX(); ++gx) {
+        shadeColumn(gx, terrain.heightAt(gx));
+    }
+    // the last column is shared with the segment still to come, so it is shaded again then
+    m_nextGX = std::max(m_nextGX, terrain.endGX() - 1);
+}
+
+void TerrainTiles::evictBefore(int gx) {
+    while (!m_cols.isEmpty() && (m_baseTX + 1) * TILE <= gx) {
+        retire(m_cols[0]);
+        m_cols.popFront();
+        ++m_baseTX;
+    }
+}
+
+void TerrainTiles::retire(Column& col) {
+    for (Tile& t : col.tiles) {
+        if (!t.texels.empty()) m_spareTexels.push_back(std::move(t.texels));
+    }
+    col.tiles.clear();
+}
+
+TerrainTiles::Column* TerrainTiles::column(int tx) {
+    if (tx < m_baseTX || tx >= m_baseTX + m_cols.size()) return nullptr;
+    return &m_cols[tx - m_baseTX];
+}
+
+const TerrainTiles::Column* TerrainTiles::column(int tx) const {
+    if (tx < m_baseTX || tx >= m_baseTX + m_cols.size()) return nullptr;
+    return &m_cols[tx - m_baseTX];
+}
+
+void TerrainTiles::shadeColumn(int gx, int groundGY) {
+    const int tx = floorDiv(gx, TILE);
+    if (m_cols.isEmpty()) m_baseTX = tx;
+    if (tx < m_baseTX) return;
+    while (m_baseTX + m_cols.size() <= tx) m_cols.pushBack(Column());
+
+    Column& col = m_cols[tx - m_baseTX];
+    const int c = gx - tx * TILE;
+    col.ground[c] = groundGY;
+    col.shaded = std::max(col.shaded, c + 1);
+
+    for (int i = 0; i < int(col.tiles.size()); ++i) {
+        shadeCell(col, tx, col.firstTY + i, col.tiles[i], c);
+    }
+    cover(col, tx, floorDiv(groundGY, TILE), floorDiv(groundGY + m_depthRows, TILE));
+}
+
+void TerrainTiles::shadeCell(Column& col, int tx, int ty, Tile& t, int c) {
+    const int gx = tx * TILE + c;
+    const int y0 = ty * TILE;
+    const int ground = col.ground[c];
+    const int top = std::clamp(ground - y0, 0, TILE);
+
+    t.top[c] = quint8(top);
+    if (top < TILE) {
+        QRgb run[TILE];
+        m_shade(run, gx, y0 + top, TILE - top, ground);
+        for (int r = top; r < TILE; ++r) t.texels[r * TILE + c] = run[r - top];
+    }
+    t.solidFrom = *std::max_element(t.top.begin(), t.top.end());
+}
+
+void TerrainTiles::cover(Column& col, int tx, int ty0, int ty1) {
+    auto shadeNew = [&](int from, int to) {
+        for (int i = from; i < to; ++i) {
+            std::vector<QRgb>& texels = col.tiles[i].texels;
+            if (!m_spareTexels.empty()) {
+                // stale texels are fine: draw() only reads rows at or below each column's top
+                texels = std::move(m_spareTexels.back());
+                m_spareTexels.pop_back();
+            } else {
+                texels.resize(TILE * TILE);
+            }
+            for (int c = 0; c < col.shaded; ++c) shadeCell(col, tx, col.firstTY + i, col.tiles[i], c);
+        }
+    };
+
+    if (col.tiles.empty()) {
+        col.firstTY = ty0;
+        col.tiles.resize(ty1 - ty0 + 1);
+        shadeNew(0, int(col.tiles.size()));
+        return;
+    }
+    if (ty0 < col.firstTY) {
+        const int add = col.firstTY - ty0;
+        col.tiles.insert(col.tiles.begin(), add, Tile());
+        col.firstTY = ty0;
+        shadeNew(0, add);
+    }
+    const int have = int(col.tiles.size());
+    if (ty1 >= col.firstTY + have) {
+        col.tiles.resize(ty1 - col.firstTY + 1);
+        shadeNew(have, int(col.tiles.size()));
+    }
+}
+
+void TerrainTiles::prepare(int camGX, int camGY, int w, int h) {
+    const int bottomTY = floorDiv(-camGY + h - 1, TILE);
+    for (int tx = floorDiv(camGX, TILE); tx <= floorDiv(camGX + w - 1, TILE); ++tx) {
+        Column* col = column(tx);
+        if (!col || col->shaded == 0 || col->tiles.empty()) continue;
+        if (bottomTY >= col->firstTY + int(col->tiles.size())) cover(*col, tx, bottomTY, bottomTY);
+    }
+}
+
+void TerrainTiles::draw(GridCanvas& g, int camGX, int camGY) const {
+    const int w = g.width();
+    const int top = g.clipTop() - camGY;      // world rows the canvas clips to
+    const int bottom = g.clipBottom() - camGY;
+    if (top >= bottom) return;
+
+    for (int tx = floorDiv(camGX, TILE); tx <= floorDiv(camGX + w - 1, TILE); ++tx) {
+        const Column* col = column(tx);
+        if (!col || col->shaded == 0 || col->tiles.empty()) continue;
+
+        const int c0 = std::max(0, camGX - tx * TILE);
+        const int c1 = std::min(TILE, camGX + w - tx * TILE);
+        const int n  = c1 - c0;
+        const int sx = tx * TILE + c0 - camGX;
+        const int lastTY = std::min(floorDiv(bottom - 1, TILE), col->firstTY + int(col->tiles.size()) - 1);
+
+        for (int ty = std::max(col->firstTY, floorDiv(top, TILE)); ty <= lastTY; ++ty) {
+            const Tile& t = col->tiles[ty - col->firstTY];
+
+            const int r0 = std::max(0, top - ty * TILE);
+            const int r1 = std::min(TILE, bottom - ty * TILE);
+            for (int r = std::max(r0, int(*std::min_element(t.top.begin() + c0, t.top.begin() + c1))); r < r1; ++r) {
+                QRgb* dst = g.scanLine(ty * TILE + r + camGY) + sx;
+                const QRgb* src = t.texels.data() + r * TILE + c0;
+                if (r >= t.solidFrom) {
+                    std::copy(src, src + n, dst);
+                } else {
+                    for (int i = 0; i < n; ++i) {
+                        if (r >= t.top[c0 + i]) dst[i] = src[i];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+// terraintiles.h
+#ifndef TERRAINTILES_H
+#define TERRAINTILES_H
+
+#include <QRgb>
+#include <array>
+#include <functional>
+#include <vector>
+#include "gridcanvas.h"
+#include "terrainstore.h"
+
+// Terrain pre-shaded into world-space tiles of TILE x TILE grid cells. A
+// column is shaded when the segment covering it is appended (the column
+// shared with the next segment once more when that arrives); each frame only
+// copies the visible tiles into the canvas. Tile columns live in a ring buffer like the heights they come
+// from and are evicted once they fall behind the retained terrain; their
+// texel buffers go back to a spare list that new tiles are carved from, so
+// scrolling along allocates nothing once the first screenful has been shaded.
+class TerrainTiles {
+public:
+    static constexpr int TILE = 64;
+
+    // Colours cells gy0 .. gy0+n-1 of column gx, whose surface is at
+    // groundGY, into out[0 .. n); only called with gy0 >= groundGY.
+    using Shader = std::function<void(QRgb* out, int gx, int gy0, int n, int groundGY)>;
+
+    // Drops every tile and shades new ones with shade from now on.
+    void reset(Shader shade);
+    // Rows under the surface shaded ahead of time; deeper tiles are shaded
+    // by prepare() on first sight.
+    void setDepth(int rows) { m_depthRows = rows; }
+
+    // Shades the columns the terrain has gained since the last call.
+    void extend(const TerrainStore& terrain);
+    // Drops tile columns that lie wholly left of grid column gx.
+    void evictBefore(int gx);
+
+    // Shades any tile a w x h view at (camGX, camGY) reaches that is deeper
+    // than what extend() covered, e.g. when the camera dips under the ground.
+    void prepare(int camGX, int camGY, int w, int h);
+    // Copies the tiles covering the canvas' clip rows, with world cell
+    // (camGX, -camGY) at the canvas origin. Sky cells are left untouched.
+    // Read-only, so bands of one frame can be drawn concurrently.
+    void draw(GridCanvas& g, int camGX, int camGY) const;
+
+private:
+    struct Tile {
+        std::vector<QRgb> texels;   // TILE * TILE once the tile is in use
+        // first terrain row of each column, TILE when the column has none here
+        std::array<quint8, TILE> top;
+        int solidFrom = TILE;   // rows from here down are terrain in every column
+        Tile() { top.fill(TILE); }
+    };
+    struct Column {
+        int firstTY = 0;
+        int shaded = 0;   // columns 0..shaded-1 have a ground height
+        std::array<int, TILE> ground {};
+        std::vector<Tile> tiles;   // tile rows firstTY, firstTY + 1, ...
+    };
+
+    void shadeColumn(int gx, int groundGY);
+    void shadeCell(Column& col, int tx, int ty, Tile& t, int c);
+    // makes sure tile rows ty0..ty1 exist, shading the ones it adds
+    void cover(Column& col, int tx, int ty0, int ty1);
+    // hands the texel buffers of col's tiles back to m_spareTexels
+    void retire(Column& col);
+    Column* column(int tx);
+    const Column* column(int tx) const;
+
+    Shader m_shade;
+    RingBuffer<Column> m_cols;
+    std::vector<std::vector<QRgb>> m_spareTexels;
+    int m_baseTX = 0;
+    int m_nextGX = 0;      // first column still to shade
+    int m_depthRows = 4 * TILE;
+};
+
+#endif // TERRAINTILES_H
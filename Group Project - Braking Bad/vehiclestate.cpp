@@ -0,0 +1,162 @@
+// vehiclestate.cpp
+#include "vehiclestate.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VEHICLESTATE_SSE2 1
+#endif
+
+void VehicleState::setEnvironment(double g, double air) {
+    m_envGravity = g;
+    m_envAirResistance = air;
+}
+
+int VehicleState::addParticle(double px, double py, double r, double w) {
+    x.push_back(px);
+    y.push_back(py);
+    vx.push_back(0.0);
+    vy.push_back(0.0);
+    prevX.push_back(px);
+    prevY.push_back(py);
+    startX.push_back(px);
+    startY.push_back(py);
+    radius.push_back(r);
+    invMass.push_back(w);
+    angle.push_back(0.0);
+    omega.push_back(0.0);
+    gravity.push_back(m_envGravity);
+    airResistance.push_back(m_envAirResistance);
+    m_dragStep = -1.0;
+    return int(x.size()) - 1;
+}
+
+int VehicleState::addLink(int a, int b, double alpha) {
+    const double dx = x[b] - x[a];
+    const double dy = y[b] - y[a];
+    linkA.push_back(a);
+    linkB.push_back(b);
+    restLength.push_back(std::sqrt(dx * dx + dy * dy));
+    compliance.push_back(std::max(0.0, alpha));
+    linkActive.push_back(1);
+    return int(linkA.size()) - 1;
+}
+
+void VehicleState::detach(int particle) {
+    for (int l = 0; l < linkCount(); ++l) {
+        if (linkA[l] == particle || linkB[l] == particle) linkActive[l] = 0;
+    }
+}
+
+void VehicleState::clear() {
+    x.clear(); y.clear();
+    vx.clear(); vy.clear();
+    prevX.clear(); prevY.clear();
+    startX.clear(); startY.clear();
+    radius.clear();
+    invMass.clear();
+    angle.clear(); omega.clear();
+    gravity.clear(); airResistance.clear();
+    m_drag.clear();
+    m_dragStep = -1.0;
+    linkA.clear(); linkB.clear();
+    restLength.clear();
+    compliance.clear();
+    linkActive.clear();
+}
+
+void VehicleState::storePrevious() {
+    std::copy(x.begin(), x.end(), prevX.begin());
+    std::copy(y.begin(), y.end(), prevY.begin());
+}
+
+void VehicleState::integrate(double h) {
+    const int n = particleCount();
+    std::copy(x.begin(), x.end(), startX.begin());
+    std::copy(y.begin(), y.end(), startY.begin());
+
+    if (h != m_dragStep) {
+        m_drag.resize(n);
+        for (int i = 0; i < n; ++i) m_drag[i] = std::pow(1 - airResistance[i], h);
+        m_dragStep = h;
+    }
+
+    double* px  = x.data();
+    double* py  = y.data();
+    double* pvx = vx.data();
+    double* pvy = vy.data();
+    const double* pg    = gravity.data();
+    const double* pdrag = m_drag.data();
+    int i = 0;
+
+#ifdef VEHICLESTATE_SSE2
+    const __m128d vh = _mm_set1_pd(h);
+    for (; i + 2 <= n; i += 2) {
+        __m128d X  = _mm_loadu_pd(px + i);
+        __m128d Y  = _mm_loadu_pd(py + i);
+        __m128d VX = _mm_loadu_pd(pvx + i);
+        __m128d VY = _mm_loadu_pd(pvy + i);
+        const __m128d G    = _mm_loadu_pd(pg + i);
+        const __m128d DRAG = _mm_loadu_pd(pdrag + i);
+        X  = _mm_add_pd(X, _mm_mul_pd(VX, vh));
+        Y  = _mm_sub_pd(Y, _mm_mul_pd(VY, vh));
+        VY = _mm_sub_pd(VY, _mm_mul_pd(G, vh));
+        VX = _mm_mul_pd(VX, DRAG);
+        VY = _mm_mul_pd(VY, DRAG);
+        _mm_storeu_pd(px + i, X);
+        _mm_storeu_pd(py + i, Y);
+        _mm_storeu_pd(pvx + i, VX);
+        _mm_storeu_pd(pvy + i, VY);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        px[i] += pvx[i] * h;
+        py[i] -= pvy[i] * h;
+        pvy[i] -= pg[i] * h;
+        pvx[i] *= pdrag[i];
+        pvy[i] *= pdrag[i];
+    }
+}
+
+void VehicleState::solveLinks(double h, double damping) {
+    if (h <= 0.0) return;
+    const double invH = 1.0 / h;
+    const double dampStep = damping * h;
+
+    // Gauss-Seidel over the links: each projection sees the previous ones, so
+    // a wheel shared by several links converges in a single pass
+    for (int l = 0; l < linkCount(); ++l) {
+        if (!linkActive[l]) continue;
+        const int a = linkA[l], b = linkB[l];
+        const double wa = invMass[a], wb = invMass[b];
+        const double wSum = wa + wb;
+        if (wSum <= 0.0) continue;
+
+        const double dx = x[b] - x[a];
+        const double dy = y[b] - y[a];
+        const double dist = std::sqrt(dx * dx + dy * dy);
+        if (dist < 1e-6) continue;
+        const double nx = dx / dist;
+        const double ny = dy / dist;
+
+        // XPBD: dLambda = -C / (w + alpha / h^2), lambda starts at 0 each step
+        const double c = dist - restLength[l];
+        const double alphaTilde = compliance[l] * invH * invH;
+        const double dLambda = -c / (wSum + alphaTilde);
+
+        // move both ends along the link and carry the move into velocity
+        const double pa = wa * dLambda, pb = wb * dLambda;
+        x[a] -= pa * nx;  y[a] -= pa * ny;
+        x[b] += pb * nx;  y[b] += pb * ny;
+        vx[a] -= pa * nx * invH;  vy[a] += pa * ny * invH;
+        vx[b] += pb * nx * invH;  vy[b] -= pb * ny * invH;
+
+        // damp the relative velocity along the link (y-up direction is (nx, -ny))
+        const double vRel = (vx[b] - vx[a]) * nx - (vy[b] - vy[a]) * ny;
+        const double impulse = vRel * std::min(1.0, dampStep * wSum) / wSum;
+        vx[a] += wa * impulse * nx;  vy[a] -= wa * impulse * ny;
+        vx[b] -= wb * impulse * nx;  vy[b] += wb * impulse * ny;
+    }
+}
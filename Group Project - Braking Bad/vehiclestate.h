@@ -0,0 +1,64 @@
+// vehiclestate.h
+#ifndef VEHICLESTATE_H
+#define VEHICLESTATE_H
+
+#include <vector>
+
+// Structure-of-arrays storage for every simulated car: point masses (wheels
+// and body centres) with their spin, and the distance links between them.
+// Each particle carries its own gravity and air resistance, so cars from
+// different stages can share one store. Free flight runs over whole arrays at
+// once, so adding cars scales with array length rather than with per-object
+// calls; links are solved as XPBD constraints. Velocities are y-up while
+// positions are screen space (y down), as in the rest of the physics.
+class VehicleState {
+public:
+    // Gravity and air resistance, per reference tick as in BiomeParams, for
+    // the particles added from now on.
+    void setEnvironment(double gravity, double airResistance);
+    int  addParticle(double x, double y, double radius, double invMass = 1.0);
+    // Links a and b at their current distance. compliance is inverse stiffness
+    // in reference ticks squared; 0 makes the link rigid. Returns the link index.
+    int  addLink(int a, int b, double compliance);
+    // Drops every link touching the particle, e.g. when the car breaks apart.
+    void detach(int particle);
+    void clear();
+
+    int particleCount() const { return int(x.size()); }
+    int linkCount()     const { return int(linkA.size()); }
+
+    void storePrevious();
+    // x += vx*h, y -= vy*h, then each particle's gravity and drag. The
+    // positions before the move are kept in startX/startY.
+    void integrate(double stepScale);
+    // One XPBD projection of every active link over a step of stepScale ticks.
+    // Position corrections are fed back into velocity, then relative velocity
+    // along each link is damped by damping per tick.
+    void solveLinks(double stepScale, double damping);
+
+    // particles
+    std::vector<double> x, y;
+    std::vector<double> vx, vy;
+    std::vector<double> prevX, prevY;    // start of the step, for render interpolation
+    std::vector<double> startX, startY;  // start of the substep, for swept contacts
+    std::vector<double> radius;
+    std::vector<double> invMass;
+    std::vector<double> angle, omega;    // orientation and spin, radians and radians per tick
+    std::vector<double> gravity, airResistance;
+
+    // links
+    std::vector<int>    linkA, linkB;
+    std::vector<double> restLength;
+    std::vector<double> compliance;
+    std::vector<char>   linkActive;
+
+private:
+    double m_envGravity = 0.0;
+    double m_envAirResistance = 0.0;
+    // (1 - airResistance)^h per particle for the step length m_dragStep, so
+    // the pow only runs again when the step length or the particles change
+    std::vector<double> m_drag;
+    double m_dragStep = -1.0;
+};
+
+#endif // VEHICLESTATE_H
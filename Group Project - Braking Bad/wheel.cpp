@@ -2,8 +2,8 @@
 #include <cmath>
 #include <algorithm>
 
-Wheel::Wheel(int x_, int y_, int radius)
-    : x(x_), y(y_), m_radius(radius)
+Wheel::Wheel(VehicleState& state, int x_, int y_, int radius)
+    : m_state(&state), m_particle(state.addParticle(x_, y_, radius)), m_radius(radius)
 {}
 
 int Wheel::radius() const {
@@ -11,35 +11,33 @@ int Wheel::radius() const {
 }
 
 void Wheel::attach(Wheel* other) {
-    m_others.append(other);
-
-    double dx = other->x - x;
-    double dy = other->y - y;
-    m_distances.append(std::sqrt(dx * dx + dy * dy));
+    m_state->addLink(m_particle, other->m_particle, Constants::AXLE_COMPLIANCE);
+    if (!m_partner) m_partner = other;
 
     m_isRoot = true;
     other->m_isRoot = false;
 }
 
 void Wheel::kill(){
-    m_others.clear();
+    m_state->detach(m_particle);
+    m_partner = nullptr;
     isAlive = false;
 }
 
 double Wheel::getX(){
-    return x;
+    return x();
 }
 
 double Wheel::getY(){
-    return y;
+    return y();
 }
 
 double Wheel::getVx(){
-    return m_vx;
+    return vx();
 }
 
 double Wheel::getVy(){
-    return m_vy;
+    return vy();
 }
 
 // void Wheel::updateR(double dx, double dy){
@@ -48,133 +46,185 @@ double Wheel::getVy(){
 // }
 
 void Wheel::updateV(double dvx, double dvy){
-    m_vx+=dvx;
-    m_vy+=dvy;
+    vx()+=dvx;
+    vy()+=dvy;
 }
 
-void Wheel::simulate(int level_index, const QList<Line>& lines, bool accelerating, bool braking, bool nitro)
+void Wheel::simulate(const BiomeParams& biome, const StepFactors& factors, const TerrainStore& terrain, bool accelerating, bool braking, bool nitro, double stepScale)
 {
-    // integrate position
-    x += m_vx;
-    y -= m_vy;
-
-    // gravity
-    m_vy -= Constants::GRAVITY[level_index];
-
-    // air drag
-    m_vx *= 1 - Constants::AIR_RESISTANCE[level_index];
-    m_vy *= 1 - Constants::AIR_RESISTANCE[level_index];
-
-    // collision with terrain lines
-    for (const Line& line : lines) {
-        double m = line.getSlope();
-        double b = line.getIntercept();
-
-        double dist = std::abs(m * x - y + b) / std::sqrt(m * m + 1);
-        double intersection_x = (m * (y - b) + x) / (m * m + 1);
-
-        int minX = std::min(line.getX1(), line.getX2());
-        int maxX = std::max(line.getX1(), line.getX2());
-
-        if (dist < std::max(1, m_radius) && intersection_x >= minX && intersection_x <= maxX) {
-            double overlap = m_radius - dist;
-            double normal_angle = std::atan2(-m, 1.0);
-
-            // push wheel out of ground
-            y -= overlap * std::cos(normal_angle);
-            x -= overlap * std::sin(normal_angle);
-
-            // rotate velocity into slope frame
-            double theta = -std::atan(m);
-            double vAlongLine    = m_vx * std::cos(theta) + m_vy * std::sin(theta);
-            double vNormalToLine = m_vy * std::cos(theta) - m_vx * std::sin(theta);
-
-            // bounce normal
-            vNormalToLine *= (vNormalToLine < 0.2) ? Constants::RESTITUTION[level_index] : 1;
-
-            // tangential friction / clamp
-            if ((vAlongLine >  Constants::MAX_VELOCITY / 1000) ||
-                (vAlongLine < -Constants::MAX_VELOCITY / 1000))
-            {
-                vAlongLine *= 1 - Constants::FRICTION[level_index];
-            } else {
-                vAlongLine = 0;
-            }
+    const double h = stepScale;
+    double& x = this->x();
+    double& y = this->y();
+    double& vx = this->vx();
+    double& vy = this->vy();
+    double& angle = this->angle();
+    double& omega = this->omega();
+
+    // collision with the terrain lines under the wheel
+    // per-contact factors come in precomputed so the contact loop is arithmetic only
+    const double reach = std::max(1, m_radius);
+    const double friction = factors.friction;
+    const double spinBleed = factors.spinBleed;
+
+    // velocity response to touching one segment, in the segment's frame
+    auto respond = [&](const Line& line) {
+        const double tx = line.tangentX(), ty = line.tangentY();
+        const double nx = line.normalX(),  ny = line.normalY();
+
+        // velocity is y-up, so its screen-space vector is (vx, -vy)
+        double vAlongLine    = vx * tx - vy * ty;
+        double vNormalToLine = vx * nx - vy * ny;
+
+        // bounce normal
+        vNormalToLine *= (vNormalToLine < 0.2) ? biome.restitution : 1;
+
+        // tangential friction / clamp
+        if ((vAlongLine >  Constants::MAX_VELOCITY / 1000) ||
+            (vAlongLine < -Constants::MAX_VELOCITY / 1000))
+        {
+            vAlongLine *= friction;
+        } else {
+            vAlongLine = 0;
+        }
 
-            // driving force along tangent
-            if (accelerating && isAlive && vAlongLine <  Constants::MAX_VELOCITY) {
-                vAlongLine += (Constants::ACCELERATION * (1 - (vAlongLine / Constants::MAX_VELOCITY)) * cos(theta) * Constants::TRACTION[level_index]);
-            }
-            if (braking && isAlive && vAlongLine > -Constants::MAX_VELOCITY) {
-                vAlongLine -= (Constants::DECELERATION * (1 + (vAlongLine / Constants::MAX_VELOCITY)) * cos(theta) * Constants::TRACTION[level_index]);
-            }
+        // driving force along tangent, scaled by how level the segment is
+        if (accelerating && isAlive && vAlongLine <  Constants::MAX_VELOCITY) {
+            vAlongLine += (Constants::ACCELERATION * (1 - (vAlongLine / Constants::MAX_VELOCITY)) * tx * biome.traction) * h;
+        }
+        if (braking && isAlive && vAlongLine > -Constants::MAX_VELOCITY) {
+            vAlongLine -= (Constants::DECELERATION * (1 + (vAlongLine / Constants::MAX_VELOCITY)) * tx * biome.traction) * h;
+        }
 
-            if(accelerating && braking){
-                m_vy -= Constants::GRAVITY[level_index] * 0.5;
-            }
+        if(accelerating && braking){
+            vy -= biome.gravity * 0.5 * h;
+        }
+
+        // back to world frame
+        vx =   vAlongLine * tx + vNormalToLine * nx;
+        vy = -(vAlongLine * ty + vNormalToLine * ny);
 
-            // rotate back to world frame
-            m_vx = vAlongLine    * std::cos(theta)
-                   - vNormalToLine * std::sin(theta);
-            m_vy = vAlongLine    * std::sin(theta)
-                   + vNormalToLine * std::cos(theta);
+        // collision bleeds some spin energy (from previous nitro code)
+        if (m_isRoot && m_partner) {
+            omega *= spinBleed;
+        }
+    };
 
-            // collision bleeds some spin energy (from previous nitro code)
-            if (m_isRoot && m_others.size() > 0 && dist < std::max(1, m_radius)) {
-                m_omega *= 0.9;
+    // swept test: the centre travelled from the substep start to (x, y) in a
+    // straight line. Take the earliest segment whose radius-offset line it
+    // crossed from above, stop there and slide the rest of the move along it,
+    // so a fast wheel cannot pass through a segment between two samples.
+    int sweptLine = -1;
+    {
+        const double sx = m_state->startX[m_particle];
+        const double sy = m_state->startY[m_particle];
+        const double mx = x - sx, my = y - sy;
+        double tHit = 1.0;
+        if (mx != 0.0 || my != 0.0) {
+            const auto [firstLine, lastLine] = terrain.range(std::min(sx, x) - reach, std::max(sx, x) + reach);
+            for (int i = firstLine; i < lastLine; ++i) {
+                const Line& line = terrain.segment(i);
+                const double nx = line.normalX(), ny = line.normalY();
+                const double h0 = (sx - line.getX1()) * nx + (sy - line.getY1()) * ny;
+                const double h1 = (x  - line.getX1()) * nx + (y  - line.getY1()) * ny;
+                if (h0 < m_radius || h1 >= m_radius) continue;
+
+                const double t = (h0 - m_radius) / (h0 - h1);
+                if (t > tHit) continue;
+                const double along = (sx + mx * t - line.getX1()) * line.tangentX()
+                                   + (sy + my * t - line.getY1()) * line.tangentY();
+                if (along < 0.0 || along > line.length()) continue;
+
+                tHit = t;
+                sweptLine = i;
             }
         }
+        if (sweptLine >= 0) {
+            const Line& line = terrain.segment(sweptLine);
+            const double tx = line.tangentX(), ty = line.tangentY();
+            const double cx = sx + mx * tHit;
+            const double cy = sy + my * tHit;
+            const double slide = (x - cx) * tx + (y - cy) * ty;
+            x = cx + slide * tx;
+            y = cy + slide * ty;
+            respond(line);
+        }
+    }
+
+    const auto [firstLine, lastLine] = terrain.range(x - reach, x + reach);
+    for (int i = firstLine; i < lastLine; ++i) {
+        if (i == sweptLine) continue;
+        const Line& line = terrain.segment(i);
+        const double tx = line.tangentX(), ty = line.tangentY();
+        const double nx = line.normalX(),  ny = line.normalY();
+
+        // wheel centre relative to the segment start, split along / across the segment
+        const double rx = x - line.getX1();
+        const double ry = y - line.getY1();
+        const double along  = rx * tx + ry * ty;
+        const double height = rx * nx + ry * ny;
+
+        if (std::abs(height) < reach && along >= 0.0 && along <= line.length()) {
+            // signed, so a centre that ended just under the line is lifted back above it
+            double overlap = m_radius - height;
+
+            // push wheel out of ground along the segment normal
+            x += overlap * nx;
+            y += overlap * ny;
+
+            respond(line);
+        }
     }
 
     // shared body tilt / rotation between two wheels (nitro-aware)
-    if (m_isRoot && m_others.size() > 0) {
-        Wheel* other = m_others.first();
+    if (m_isRoot && m_partner) {
+        Wheel* other = m_partner;
 
         // angular control:
         // 1. nitro: mild damping of omega (straight flight)
         // 2. accel only: tilt backward (wheelie)
         // 3. brake only: tilt forward (nose down)
         // 4. none: passive damping
+        const double angularDamping = factors.angularDamping;
         if (nitro) {
-            m_omega *= 1 - Constants::ANGULAR_DAMPING;
-            if (std::abs(m_omega) < 1e-4) m_omega = 0.0;
+            omega *= angularDamping;
+            if (std::abs(omega) < 1e-4) omega = 0.0;
         } if (accelerating && braking) {
-            m_angle = std::atan2(other->getY() - this->getY(), other->getX() - this->getX());
+            angle = std::atan2(other->getY() - this->getY(), other->getX() - this->getX());
 
-            if (std::abs(m_angle) > 1e-2) {
-                if (m_angle > 0) m_omega += Constants::ANGULAR_ACCELERATION;
-                else m_omega -= Constants::ANGULAR_DECELERATION;
+            if (std::abs(angle) > 1e-2) {
+                if (angle > 0) omega += Constants::ANGULAR_ACCELERATION * h;
+                else omega -= Constants::ANGULAR_DECELERATION * h;
             }
-            m_omega *= 1 - Constants::ANGULAR_DAMPING;
-            if (std::abs(m_omega) < 1e-4) m_omega = 0.0;
+            omega *= angularDamping;
+            if (std::abs(omega) < 1e-4) omega = 0.0;
         } else if (accelerating) {
-            m_omega += Constants::ANGULAR_ACCELERATION;
-            if (m_omega >  Constants::MAX_ANGULAR_VELOCITY) m_omega =  Constants::MAX_ANGULAR_VELOCITY;
+            omega += Constants::ANGULAR_ACCELERATION * h;
+            if (omega >  Constants::MAX_ANGULAR_VELOCITY) omega =  Constants::MAX_ANGULAR_VELOCITY;
         } else if (braking) {
-            m_omega -= Constants::ANGULAR_DECELERATION;
-            if (m_omega < -Constants::MAX_ANGULAR_VELOCITY) m_omega = -Constants::MAX_ANGULAR_VELOCITY;
+            omega -= Constants::ANGULAR_DECELERATION * h;
+            if (omega < -Constants::MAX_ANGULAR_VELOCITY) omega = -Constants::MAX_ANGULAR_VELOCITY;
         } else {
-            m_omega *= 1 - Constants::ANGULAR_DAMPING;
-            if (std::abs(m_omega) < 1e-4) m_omega = 0.0;
+            omega *= angularDamping;
+            if (std::abs(omega) < 1e-4) omega = 0.0;
         }
 
         // integrate angle and wrap
-        // m_angle += m_omega;
-        // if (m_angle >  M_PI) m_angle -= 2 * M_PI;
-        // else if (m_angle < -M_PI) m_angle += 2 * M_PI;
+        // angle += omega;
+        // if (angle >  M_PI) angle -= 2 * M_PI;
+        // else if (angle < -M_PI) angle += 2 * M_PI;
 
         // apply incremental rotation of the wheel pair about COM
-        if (std::abs(m_omega) > 1e-6) {
-            double cx = (x + other->x) / 2.0;
-            double cy = (y + other->y) / 2.0;
+        if (std::abs(omega) > 1e-6) {
+            double cx = (x + other->x()) / 2.0;
+            double cy = (y + other->y()) / 2.0;
 
             double rx1 = x - cx;
             double ry1 = y - cy;
-            double rx2 = other->x - cx;
-            double ry2 = other->y - cy;
+            double rx2 = other->x() - cx;
+            double ry2 = other->y() - cy;
 
-            double sinA = std::sin(m_omega);
-            double cosA = std::cos(m_omega);
+            double sinA = std::sin(omega * h);
+            double cosA = std::cos(omega * h);
 
             double nx1 = rx1 * cosA + ry1 * sinA;
             double ny1 = - rx1 * sinA + ry1 * cosA;
@@ -184,55 +234,30 @@ void Wheel::simulate(int level_index, const QList<Line>& lines, bool acceleratin
 
             x = cx + nx1;
             y = cy + ny1;
-            other->x = cx + nx2;
-            other->y = cy + ny2;
+            other->x() = cx + nx2;
+            other->y() = cy + ny2;
         }
     }
+}
 
-    // spring-damper keeping wheel distances
-    for (int i = 0; i < m_others.size(); ++i) {
-        Wheel* other = m_others.at(i);
-        double desiredDistance = m_distances.at(i);
-
-        double deltaX = other->x - x;
-        double deltaY = other->y - y;
-        double actualDistance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
-        if (actualDistance <= 0.01) actualDistance = 0.01;
-
-        double displacement = actualDistance - desiredDistance;
-        double springForceMagnitude = displacement * Constants::SPRING_CONSTANT;
-
-        double unitX = -deltaX / actualDistance;
-        double unitY =  deltaY / actualDistance;
-
-        double forceX = unitX * springForceMagnitude;
-        double forceY = unitY * springForceMagnitude;
-
-        // 2. Calculate relative velocity
-        double relativeVx = other->getVx() - m_vx;
-        double relativeVy = other->getVy() - m_vy;
-
-        // 3. Project relative velocity onto the spring axis (Dot Product)
-        // This isolates the component of velocity that is stretching/compressing the spring
-        double velocityAlongSpring = relativeVx * unitX + relativeVy * unitY;
-
-        // 4. Calculate damping force components based ONLY on that projection
-        double dampingForceX = velocityAlongSpring * unitX * Constants::DAMPING;
-        double dampingForceY = velocityAlongSpring * unitY * Constants::DAMPING;
+WheelPose Wheel::pose(double alpha) const
+{
+    const double prevX = m_state->prevX[m_particle];
+    const double prevY = m_state->prevY[m_particle];
+    return {prevX + (this->x() - prevX) * alpha, prevY + (this->y() - prevY) * alpha, m_radius};
+}
 
-        m_vx -= (forceX - dampingForceX);
-        m_vy -= (forceY - dampingForceY);
-        other->m_vx += (forceX - dampingForceX);
-        other->m_vy += (forceY - dampingForceY);
-    }
+std::optional<std::array<int, 3>> Wheel::get(int x1, int y1, int x2, int y2, int cx, int cy, double alpha) const
+{
+    return pose(alpha).get(x1, y1, x2, y2, cx, cy);
 }
 
-std::optional<std::array<int, 3>> Wheel::get(int x1, int y1, int x2, int y2, int cx, int cy) const
+std::optional<std::array<int, 3>> WheelPose::get(int x1, int y1, int x2, int y2, int cx, int cy) const
 {
-    if (x + m_radius + cx < x1 ||
-        x - m_radius + cx > x2 ||
-        y + m_radius + cy < y1 ||
-        y - m_radius + cy > y2)
+    if (x + radius + cx < x1 ||
+        x - radius + cx > x2 ||
+        y + radius + cy < y1 ||
+        y - radius + cy > y2)
     {
         return std::nullopt;
     }
@@ -240,6 +265,6 @@ std::optional<std::array<int, 3>> Wheel::get(int x1, int y1, int x2, int y2, int
     return std::array<int,3>{
         static_cast<int>(std::lround(x + cx)),
         static_cast<int>(std::lround(y + cy)),
-        m_radius
+        radius
     };
 }
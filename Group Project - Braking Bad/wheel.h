@@ -2,30 +2,60 @@
 #define WHEEL_H
 
 #include "line.h"
+#include "terrainstore.h"
 #include "constants.h"
-#include <QList>
+#include "vehiclestate.h"
 #include <optional>
 #include <array>
 
+// Where a wheel is drawn: its centre in world pixels, already blended between
+// two physics steps, and its radius. Plain data, so it can be copied out of
+// the simulation and drawn while the next ticks run.
+struct WheelPose {
+    double x = 0.0;
+    double y = 0.0;
+    int radius = 0;
+
+    // (centerX, centerY, radius) after camera offset, or nothing when the
+    // wheel lies outside (x1, y1)-(x2, y2)
+    std::optional<std::array<int, 3>> get(int x1, int y1, int x2, int y2, int cx, int cy) const;
+};
+
+// A wheel is a handle onto one particle of a VehicleState: position, velocity
+// and spin live in the shared arrays, the wheel keeps its contact logic.
 class Wheel {
 public:
-    double x = 0.0, y = 0.0;
-    double m_vx = 0.0, m_vy = 0.0;
     bool isAlive = true;
-    double m_angle = 0.0;
-    double m_omega = 0.0;
     bool m_isRoot = false;
 
-    Wheel(int x, int y, int radius);
+    Wheel(VehicleState& state, int x, int y, int radius);
     int radius() const;
+    int particle() const { return m_particle; }
+
+    double& x()  { return m_state->x[m_particle]; }
+    double& y()  { return m_state->y[m_particle]; }
+    double& vx() { return m_state->vx[m_particle]; }
+    double& vy() { return m_state->vy[m_particle]; }
+    double x()  const { return m_state->x[m_particle]; }
+    double y()  const { return m_state->y[m_particle]; }
+    double vx() const { return m_state->vx[m_particle]; }
+    double vy() const { return m_state->vy[m_particle]; }
+    // tilt of a root wheel's pair and how fast it turns
+    double& angle() { return m_state->angle[m_particle]; }
+    double& omega() { return m_state->omega[m_particle]; }
 
     void attach(Wheel* other);
 
-    // signature with nitro stays
-    void simulate(int, const QList<Line>& lines, bool accelerating, bool braking, bool nitro);
+    // terrain contacts and pair rotation; free flight and the links are
+    // integrated for all wheels at once by VehicleState
+    // stepScale is the step length in reference ticks (1.0 at PHYSICS_REFERENCE_HZ)
+    // factors is StepFactors::of(biome, stepScale)
+    void simulate(const BiomeParams& biome, const StepFactors& factors, const TerrainStore& terrain, bool accelerating, bool braking, bool nitro, double stepScale = 1.0);
 
-    // (centerX, centerY, radius) for rendering after camera offset
-    std::optional<std::array<int, 3>> get(int x1, int y1, int x2, int y2, int cx, int cy) const;
+    // (centerX, centerY, radius) for rendering after camera offset,
+    // alpha blends from the previous step's position (0) to the current one (1)
+    std::optional<std::array<int, 3>> get(int x1, int y1, int x2, int y2, int cx, int cy, double alpha = 1.0) const;
+    WheelPose pose(double alpha = 1.0) const;
 
     double getVx();
     double getVy();
@@ -37,9 +67,11 @@ public:
     // void updateR(double dx, double dy);
 
 private:
+    VehicleState* m_state;
+    int m_particle;
     int m_radius;
-    QList<Wheel*> m_others;
-    QList<double> m_distances;
+    // first wheel attached to a root wheel; the pair is tilted together
+    Wheel* m_partner = nullptr;
 
     // constants from your tuned "code 1" physics (:contentReference[oaicite:8]{index=8})
 
@@ -0,0 +1,49 @@
+// workerthread.cpp
+#include "workerthread.h"
+#include <QMutexLocker>
+#include <QThread>
+
+WorkerThread::WorkerThread(std::function<void()> task)
+    : m_task(std::move(task)),
+    m_thread(QThread::create([this] { loop(); }))
+{
+    m_thread->start();
+}
+
+WorkerThread::~WorkerThread() {
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_busy) m_finished.wait(&m_mutex);
+        m_quit = true;
+        m_started.wakeOne();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void WorkerThread::start() {
+    QMutexLocker lock(&m_mutex);
+    while (m_busy) m_finished.wait(&m_mutex);
+    m_busy = true;
+    m_started.wakeOne();
+}
+
+void WorkerThread::wait() {
+    QMutexLocker lock(&m_mutex);
+    while (m_busy) m_finished.wait(&m_mutex);
+}
+
+void WorkerThread::loop() {
+    QMutexLocker lock(&m_mutex);
+    for (;;) {
+        while (!m_busy && !m_quit) m_started.wait(&m_mutex);
+        if (!m_busy) return;
+
+        lock.unlock();
+        m_task();
+        lock.relock();
+
+        m_busy = false;
+        m_finished.wakeAll();
+    }
+}
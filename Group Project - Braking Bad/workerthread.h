@@ -0,0 +1,41 @@
+// workerthread.h
+#ifndef WORKERTHREAD_H
+#define WORKERTHREAD_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+
+class QThread;
+
+// One thread kept for the life of its owner that runs the same task each time
+// it is started and sleeps on a wait condition in between. A job that runs
+// every frame costs a wake-up rather than a thread-pool submission, and
+// nothing is allocated after construction.
+class WorkerThread {
+public:
+    explicit WorkerThread(std::function<void()> task);
+    // finishes a run in flight, then stops the thread
+    ~WorkerThread();
+
+    WorkerThread(const WorkerThread&) = delete;
+    WorkerThread& operator=(const WorkerThread&) = delete;
+
+    // Runs the task once on the thread. A run already started is waited for first.
+    void start();
+    // Blocks until the last run started has finished; returns at once when idle.
+    void wait();
+
+private:
+    void loop();
+
+    std::function<void()> m_task;
+    QThread* m_thread = nullptr;
+    QMutex m_mutex;
+    QWaitCondition m_started;   // start() or the destructor has something for loop()
+    QWaitCondition m_finished;  // loop() has finished a run
+    bool m_busy = false;
+    bool m_quit = false;
+};
+
+#endif // WORKERTHREAD_H
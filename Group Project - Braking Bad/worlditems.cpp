@@ -0,0 +1,146 @@
+// worlditems.cpp
+#include "worlditems.h"
+#include "wheel.h"
+#include "carBody.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const std::array<WorldItems::KindInfo, WorldItems::KIND_COUNT> WorldItems::KINDS = {{
+    {true},    // Coin
+    {false},   // FuelCan
+}};
+
+WorldItems& WorldItems::operator=(const WorldItems& other) {
+    if (this == &other) return *this;
+    const size_t h = size_t(other.m_head);
+    m_x.assign(other.m_x.begin() + h, other.m_x.end());
+    m_y.assign(other.m_y.begin() + h, other.m_y.end());
+    m_kind.assign(other.m_kind.begin() + h, other.m_kind.end());
+    m_radius.assign(other.m_radius.begin() + h, other.m_radius.end());
+    m_head = 0;
+    m_maxRadius = other.m_maxRadius;
+    return *this;
+}
+
+void WorldItems::clear() {
+    m_x.clear(); m_y.clear(); m_kind.clear(); m_radius.clear();
+    m_head = 0;
+    m_maxRadius = 0;
+}
+
+void WorldItems::add(ItemKind k, int wx, int wy, int r) {
+    // spawns arrive in X order almost always, so this is an append
+    const size_t i = std::upper_bound(m_x.begin() + m_head, m_x.end(), wx) - m_x.begin();
+    m_x.insert(m_x.begin() + i, wx);
+    m_y.insert(m_y.begin() + i, wy);
+    m_kind.insert(m_kind.begin() + i, k);
+    m_radius.insert(m_radius.begin() + i, r);
+    m_maxRadius = std::max(m_maxRadius, r);
+}
+
+void WorldItems::evictBefore(int minX) {
+    m_head = int(std::lower_bound(m_x.begin() + m_head, m_x.end(), minX) - m_x.begin());
+    if (m_head == int(m_x.size())) {
+        m_x.clear(); m_y.clear(); m_kind.clear(); m_radius.clear();
+        m_head = 0;
+    } else if (m_head > size()) {
+        m_x.erase(m_x.begin(), m_x.begin() + m_head);
+        m_y.erase(m_y.begin(), m_y.begin() + m_head);
+        m_kind.erase(m_kind.begin(), m_kind.begin() + m_head);
+        m_radius.erase(m_radius.begin(), m_radius.begin() + m_head);
+        m_head = 0;
+    }
+}
+
+std::pair<int, int> WorldItems::range(int minX, int maxX) const {
+    const auto first = m_x.begin() + m_head;
+    const auto lo = std::lower_bound(first, m_x.end(), minX);
+    const auto hi = std::upper_bound(lo, m_x.end(), maxX);
+    return {int(lo - first), int(hi - first)};
+}
+
+std::array<int, WorldItems::KIND_COUNT> WorldItems::collect(const QList<Wheel*>& wheels, const QList<CarBody*>& bodies) {
+    std::array<int, KIND_COUNT> collected{};
+    if (isEmpty()) return collected;
+
+    // broad phase: a box around everything that collects
+    double minX = std::numeric_limits<double>::max(), maxX = std::numeric_limits<double>::lowest();
+    double minY = minX, maxY = maxX;
+    auto cover = [&](double px, double py) {
+        minX = std::min(minX, px); maxX = std::max(maxX, px);
+        minY = std::min(minY, py); maxY = std::max(maxY, py);
+    };
+    for (const Wheel* w : wheels) cover(w->x(), w->y());
+    for (const CarBody* body : bodies) {
+        for (const QPoint& pt : body->getOutline()) cover(pt.x(), pt.y());
+    }
+    if (minX > maxX) return collected;
+
+    const auto [first, last] = range(int(std::floor(minX)) - m_maxRadius, int(std::ceil(maxX)) + m_maxRadius);
+
+    // narrow phase
+    auto ptSegDist2 = [](double px, double py, const Line& ln)->double {
+        double x1 = ln.getX1(), y1 = ln.getY1();
+        double x2 = ln.getX2(), y2 = ln.getY2();
+        double vx = x2 - x1,   vy = y2 - y1;
+        double wx = px - x1,   wy = py - y1;
+        double len2 = vx*vx + vy*vy;
+        double t = (len2 > 0.0) ? (wx*vx + wy*vy) / len2 : 0.0;
+        if (t < 0.0) t = 0.0; else if (t > 1.0) t = 1.0;
+        double cx = x1 + t*vx, cy = y1 + t*vy;
+        double dx = px - cx,   dy = py - cy;
+        return dx*dx + dy*dy;
+    };
+
+    auto hit = [&](size_t i) {
+        const double px = m_x[i], py = m_y[i];
+        const double r = m_radius[i];
+        if (px < minX - r || px > maxX + r || py < minY - r || py > maxY + r) return false;
+
+        for (const Wheel* w : wheels) {
+            const double dx = w->x() - px;
+            const double dy = w->y() - py;
+            if (dx*dx + dy*dy <= r*r) return true;
+        }
+        if (!KINDS[size_t(m_kind[i])].bodyCollects) return false;
+
+        for (const CarBody* body : bodies) {
+            for (const Line& ln : body->getLines()) {
+                if (ptSegDist2(px, py, ln) <= r*r) return true;
+            }
+
+            // even-odd crossing test against the outline, the pickup point inside the body
+            const QVector<QPoint>& outline = body->getOutline();
+            bool inside = false;
+            for (int a = 0, b = outline.size() - 1; a < outline.size(); b = a++) {
+                const QPoint& pa = outline[a];
+                const QPoint& pb = outline[b];
+                if ((pa.y() > py) != (pb.y() > py) &&
+                    px < double(pb.x() - pa.x()) * (py - pa.y()) / double(pb.y() - pa.y()) + pa.x())
+                    inside = !inside;
+            }
+            if (inside) return true;
+        }
+        return false;
+    };
+
+    // compact the candidate range in place, every pool alike
+    const size_t begin = size_t(m_head + first), end = size_t(m_head + last);
+    size_t out = begin;
+    for (size_t i = begin; i < end; ++i) {
+        if (hit(i)) {
+            ++collected[size_t(m_kind[i])];
+            continue;
+        }
+        m_x[out] = m_x[i]; m_y[out] = m_y[i]; m_kind[out] = m_kind[i]; m_radius[out] = m_radius[i];
+        ++out;
+    }
+    if (out < end) {
+        m_x.erase(m_x.begin() + out, m_x.begin() + end);
+        m_y.erase(m_y.begin() + out, m_y.begin() + end);
+        m_kind.erase(m_kind.begin() + out, m_kind.begin() + end);
+        m_radius.erase(m_radius.begin() + out, m_radius.begin() + end);
+    }
+    return collected;
+}
@@ -0,0 +1,74 @@
+// worlditems.h
+#ifndef WORLDITEMS_H
+#define WORLDITEMS_H
+
+#include <QList>
+#include <QtGlobal>
+#include <array>
+#include <utility>
+#include <vector>
+
+class Wheel;
+class CarBody;
+
+// the kinds of item the car can collect; KINDS holds how each is picked up
+enum class ItemKind : quint8 { Coin, FuelCan };
+
+// Coins, fuel cans and anything else the car collects, as structure-of-arrays
+// pools ordered by world X: spawn systems (CoinSystem, FuelSystem) add()
+// near the generated edge, and the passes below each sweep one X range of
+// the pools. A new kind is an ItemKind value, a row in KINDS and a sprite in
+// the driver's ItemRenderer. Plain data, so the headless runner and the
+// render snapshot carry it without any drawing code. Like WorldWindow,
+// evicting only moves a head index and the dead prefix is compacted away
+// once it outgrows the live items; copies take the live items only.
+class WorldItems {
+public:
+    static constexpr int KIND_COUNT = 2;
+
+    WorldItems() = default;
+    WorldItems(const WorldItems& other) { *this = other; }
+    WorldItems& operator=(const WorldItems& other);
+
+    struct KindInfo {
+        bool bodyCollects;   // besides the wheels, the car body picks it up
+    };
+    static const std::array<KindInfo, KIND_COUNT> KINDS;
+
+    int  size() const    { return int(m_x.size()) - m_head; }
+    bool isEmpty() const { return size() == 0; }
+    void clear();
+
+    // spawn: an item whose pickup point is (wx, wy), collected within radius
+    void add(ItemKind kind, int wx, int wy, int radius);
+
+    // cull: drops the items with x < minX, e.g. behind the oldest terrain kept
+    void evictBefore(int minX);
+
+    // pickup: one pass over the items the wheels or the bodies can reach. A
+    // box around both picks the candidates; those get the exact tests (a
+    // wheel centre within the radius; for body-collected kinds, a body edge
+    // within it or the pickup point inside the outline). Collected items are
+    // removed; returns how many of each kind. Pass no wheels when they do
+    // not collect, e.g. with the car upside down.
+    std::array<int, KIND_COUNT> collect(const QList<Wheel*>& wheels, const QList<CarBody*>& bodies);
+
+    // Index range [first, last) of the items with minX <= x <= maxX.
+    std::pair<int, int> range(int minX, int maxX) const;
+
+    // item i, counted from the oldest live one
+    int      x(int i) const      { return m_x[size_t(m_head + i)]; }
+    int      y(int i) const      { return m_y[size_t(m_head + i)]; }
+    ItemKind kind(int i) const   { return m_kind[size_t(m_head + i)]; }
+    int      radius(int i) const { return m_radius[size_t(m_head + i)]; }
+
+private:
+    // pools, one entry per item, ordered by x
+    std::vector<int>      m_x, m_y;     // pickup point, world pixels
+    std::vector<ItemKind> m_kind;
+    std::vector<int>      m_radius;     // pickup radius, world pixels
+    int m_head = 0;                     // entries [0, m_head) are evicted
+    int m_maxRadius = 0;
+};
+
+#endif // WORLDITEMS_H
@@ -0,0 +1,65 @@
+// worldwindow.h
+#ifndef WORLDWINDOW_H
+#define WORLDWINDOW_H
+
+#include <QVector>
+#include <algorithm>
+#include <utility>
+
+// Things placed along the track, ordered by their world X (member X of T).
+// New ones arrive near the generated edge on the right and evictBefore()
+// drops the ones the terrain has left behind, so the window holds about one
+// terrain window's worth however long the run. Evicting only moves a head
+// index; the dead prefix is compacted away once it outgrows the live items,
+// so sliding forward costs O(1) per item amortised.
+template <typename T, int T::*X>
+class WorldWindow {
+public:
+    int  size() const    { return m_items.size() - m_head; }
+    bool isEmpty() const { return size() == 0; }
+    void clear()         { m_items.clear(); m_head = 0; }
+
+    const T& operator[](int i) const { return m_items[m_head + i]; }
+    T&       operator[](int i)       { return m_items[m_head + i]; }
+    const T& last() const { return m_items.last(); }
+    typename QVector<T>::const_iterator begin() const { return m_items.cbegin() + m_head; }
+    typename QVector<T>::const_iterator end() const   { return m_items.cend(); }
+
+    // Adds t after every item at the same or a smaller X.
+    void insert(const T& t) {
+        if (isEmpty() || m_items.last().*X <= t.*X) {
+            m_items.append(t);
+            return;
+        }
+        auto it = std::upper_bound(m_items.begin() + m_head, m_items.end(), t.*X,
+                                   [](int x, const T& item) { return x < item.*X; });
+        m_items.insert(it, t);
+    }
+
+    // Drops the items with X < minX.
+    void evictBefore(int minX) {
+        m_head = int(std::lower_bound(m_items.cbegin() + m_head, m_items.cend(), minX,
+                                      [](const T& item, int x) { return item.*X < x; }) - m_items.cbegin());
+        if (m_head == m_items.size()) {
+            clear();
+        } else if (m_head > m_items.size() - m_head) {
+            m_items.erase(m_items.begin(), m_items.begin() + m_head);
+            m_head = 0;
+        }
+    }
+
+    // Index range [first, last) of the items with minX <= X <= maxX.
+    std::pair<int, int> range(int minX, int maxX) const {
+        auto lo = std::lower_bound(begin(), end(), minX,
+                                   [](const T& item, int x) { return item.*X < x; });
+        auto hi = std::upper_bound(lo, end(), maxX,
+                                   [](int x, const T& item) { return x < item.*X; });
+        return {int(lo - begin()), int(hi - begin())};
+    }
+
+private:
+    QVector<T> m_items;
+    int m_head = 0;   // m_items[0 .. m_head) are evicted
+};
+
+#endif // WORLDWINDOW_H